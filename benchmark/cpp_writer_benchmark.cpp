@@ -0,0 +1,215 @@
+/// \file
+/// Measures how fast \ref apigen::cpp_writer writes a large generated source file. The same synthetic workload, which
+/// resembles the function bodies in host.cpp, is written with different flushing strategies, and with a writer that
+/// sends every token directly to the \p std::ostream like \ref apigen::cpp_writer used to.
+///
+/// Usage: cpp_writer_benchmark [output file] [megabytes] [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <fmt/ostream.h>
+
+#include "cpp_writer.h"
+
+namespace apigen::benchmark {
+	/// A writer that forwards every token to the output stream without buffering. It mirrors the interface and the
+	/// indentation rules of \ref cpp_writer that are used by the workload.
+	class stream_writer {
+	public:
+		/// Scopes are ended when this token is destroyed.
+		struct scope_token {
+		public:
+			/// Initializes \ref _out.
+			explicit scope_token(stream_writer *w) : _out(w) {
+			}
+			/// No copy construction.
+			scope_token(const scope_token&) = delete;
+			/// No copy assignment.
+			scope_token &operator=(const scope_token&) = delete;
+			/// Ends the scope.
+			~scope_token() {
+				_out->_end_scope();
+			}
+		protected:
+			stream_writer *_out = nullptr; ///< The associated \ref stream_writer.
+		};
+
+		/// Initializes \ref _out.
+		explicit stream_writer(std::ostream &out) : _out(&out) {
+		}
+
+		/// Writes the given object to the output stream.
+		template <typename T> stream_writer &write(T &&obj) {
+			*_out << std::forward<T>(obj);
+			return *this;
+		}
+		/// Formats and writes to the output stream.
+		template <typename ...Args> stream_writer &write_fmt(Args &&...args) {
+			fmt::print(*_out, std::forward<Args>(args)...);
+			return *this;
+		}
+		/// Starts a new line, writing the indentation one tab at a time.
+		stream_writer &new_line() {
+			*_out << '\n';
+			if (!_scopes.empty() && !_scopes.back().second) {
+				++_indent;
+				_scopes.back().second = true;
+			}
+			for (std::size_t i = 0; i < _indent; ++i) {
+				*_out << '\t';
+			}
+			return *this;
+		}
+		/// Starts a scope.
+		[[nodiscard]] scope_token begin_scope(cpp_writer::scope s) {
+			_scopes.emplace_back(s.end, false);
+			write(s.begin);
+			return scope_token(this);
+		}
+	protected:
+		/// Ends the bottom-level scope.
+		void _end_scope() {
+			if (_scopes.back().second) {
+				--_indent;
+				new_line();
+			}
+			write(_scopes.back().first);
+			_scopes.pop_back();
+		}
+
+		/// The end delimiters of all current scopes, and whether a new line has been written in them.
+		std::vector<std::pair<std::string_view, bool>> _scopes;
+		std::ostream *_out = nullptr; ///< The output stream.
+		std::size_t _indent = 0; ///< The level of indentation.
+	};
+
+	/// Writes a function similar to the wrappers in host.cpp.
+	template <typename Writer> void write_function(Writer &writer, std::size_t index) {
+		writer
+			.new_line()
+			.write_fmt("void _apigen_priv_impl_{}(void *_apigen_priv_param_object, int _apigen_priv_param_n) ", index);
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			writer
+				.new_line()
+				.write_fmt("auto &_apigen_priv_local_obj = *static_cast<ns::record_{} *>(", index % 97)
+				.write("_apigen_priv_param_object")
+				.write(");")
+				.new_line()
+				.write("for (int i = 0; i < _apigen_priv_param_n; ++i) ");
+			{
+				auto loop = writer.begin_scope(cpp_writer::braces_scope);
+				writer
+					.new_line()
+					.write_fmt("_apigen_priv_local_obj.field_{}[i] = ", index % 13)
+					.write_fmt("ns::convert<{}>(_apigen_priv_local_obj.field_{}[i]);", index % 7, index % 11);
+			}
+			writer
+				.new_line()
+				.write("return;");
+		}
+		writer.new_line();
+	}
+
+	/// Returns the number of seconds taken by the given function.
+	template <typename Func> [[nodiscard]] double time(Func &&func) {
+		auto begin = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+}
+
+int main(int argc, char **argv) {
+	using namespace apigen;
+	using namespace apigen::benchmark;
+
+	std::string path = argc > 1 ? argv[1] : "cpp_writer_benchmark.out";
+	std::size_t megabytes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+	std::size_t repetitions = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 5;
+
+	clang::PrintingPolicy policy{ clang::LangOptions() };
+	// the number of functions is chosen so that the output has roughly the requested size
+	std::size_t function_size;
+	{
+		cpp_writer sample(policy);
+		write_function(sample, 0);
+		function_size = sample.get_buffered_contents().size();
+	}
+	std::size_t num_functions = megabytes * 1024 * 1024 / function_size;
+
+	// writes the workload using a cpp_writer; if a threshold is given, the writer is also flushed whenever it buffers
+	// at least that many bytes, which emulates smaller values of cpp_writer::flush_threshold, and zero keeps
+	// everything in memory and writes the file with a single call
+	auto write_cpp_writer = [&](std::optional<std::size_t> threshold) {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (threshold && threshold.value() == 0) {
+			cpp_writer writer(policy);
+			for (std::size_t i = 0; i < num_functions; ++i) {
+				write_function(writer, i);
+			}
+			std::string_view contents = writer.get_buffered_contents();
+			out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+			return;
+		}
+		cpp_writer writer(out, policy);
+		for (std::size_t i = 0; i < num_functions; ++i) {
+			write_function(writer, i);
+			if (threshold && writer.get_buffered_contents().size() >= threshold.value()) {
+				writer.flush();
+			}
+		}
+	};
+
+	struct strategy {
+		std::string name; ///< The name of this strategy.
+		std::function<void()> run; ///< Writes the workload.
+	};
+	std::vector<strategy> strategies;
+	strategies.push_back({ "ostream per token", [&]() {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		stream_writer writer(out);
+		for (std::size_t i = 0; i < num_functions; ++i) {
+			write_function(writer, i);
+		}
+	} });
+	for (std::size_t kilobytes : { 4, 64, 256, 1024 }) {
+		strategies.push_back({ fmt::format("flush at {} KiB", kilobytes), [&, kilobytes]() {
+			write_cpp_writer(kilobytes * 1024);
+		} });
+	}
+	strategies.push_back({
+		fmt::format("flush_threshold ({} KiB)", cpp_writer::flush_threshold / 1024),
+		[&]() {
+			write_cpp_writer(std::nullopt);
+		}
+	});
+	strategies.push_back({ "single write", [&]() {
+		write_cpp_writer(0);
+	} });
+
+	fmt::print(
+		"{} functions, {:.1f} MiB, best of {} runs\n",
+		num_functions, static_cast<double>(num_functions * function_size) / (1024 * 1024), repetitions
+	);
+	for (strategy &strat : strategies) {
+		double best = 0.0;
+		for (std::size_t i = 0; i < repetitions; ++i) {
+			double seconds = time(strat.run);
+			best = i == 0 ? seconds : std::min(best, seconds);
+		}
+		fmt::print(
+			"{:<28}{:>10.3f} s{:>10.1f} MiB/s\n",
+			strat.name, best, static_cast<double>(num_functions * function_size) / (1024 * 1024) / best
+		);
+	}
+	std::remove(path.c_str());
+	return 0;
+}
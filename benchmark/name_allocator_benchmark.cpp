@@ -0,0 +1,133 @@
+/// \file
+/// Measures how fast \ref apigen::name_allocator disambiguates a heavily overloaded name. Overloads of the same name
+/// are allocated across a chain of nested scopes, either with eagerly computed disambiguation postfixes or with
+/// producers that compute them only when there's a conflict, and either with postfixes that tell the overloads apart
+/// or with identical postfixes that need to be numbered. As a reference, the same number of functions with different
+/// names are allocated, for which lazy producers are never called.
+///
+/// Usage: name_allocator_benchmark [overloads] [scope depth] [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "cpp_writer.h"
+
+namespace apigen::benchmark {
+	/// Returns a postfix similar to the ones computed from the parameter types of an overloaded function. This is
+	/// deliberately not trivial, since computing it is the cost that lazy disambiguation avoids.
+	[[nodiscard]] std::string parameter_postfix(std::size_t index, bool unique) {
+		std::string result = "_";
+		std::size_t value = unique ? index : 0;
+		for (std::size_t i = 0; i < 4; ++i) {
+			result += fmt::format("_ns_param_type_{}", value % 10);
+			value /= 10;
+		}
+		if (unique) {
+			result += fmt::format("_{}", index);
+		}
+		return result;
+	}
+
+	/// The result of allocating all overloads once.
+	struct result {
+		std::size_t postfixes_computed = 0; ///< The number of disambiguation postfixes that have been computed.
+		bool names_unique = true; ///< Whether all final names are different.
+	};
+
+	/// Allocates \p overloads function names across \p depth nested scopes, and checks that all final names are
+	/// different. If \p overloaded is \p false, the functions have different names instead of being overloads.
+	[[nodiscard]] result allocate_overloads(
+		std::size_t overloads, std::size_t depth, bool overloaded, bool lazy, bool unique
+	) {
+		result res;
+		std::vector<name_allocator> scopes;
+		scopes.reserve(depth);
+		scopes.emplace_back();
+		for (std::size_t i = 1; i < depth; ++i) {
+			scopes.emplace_back(name_allocator::from_parent(scopes.back()));
+		}
+
+		std::vector<name_allocator::token> tokens;
+		tokens.reserve(overloads);
+		for (std::size_t i = 0; i < overloads; ++i) {
+			// parent scopes are populated before their children, like in the exporter
+			name_allocator &scope = scopes[i * depth / overloads];
+			std::string name = overloaded ? "function" : fmt::format("function_{}", i);
+			if (lazy) {
+				tokens.emplace_back(scope.allocate_variable_custom(std::move(name), [&res, i, unique]() {
+					++res.postfixes_computed;
+					return parameter_postfix(i, unique);
+				}));
+			} else {
+				++res.postfixes_computed;
+				tokens.emplace_back(scope.allocate_variable_custom(std::move(name), parameter_postfix(i, unique)));
+			}
+		}
+
+		std::unordered_set<std::string> names;
+		for (const name_allocator::token &tok : tokens) {
+			if (!names.emplace(tok->get_name()).second) {
+				res.names_unique = false;
+			}
+		}
+		return res;
+	}
+
+	/// Returns the number of seconds taken by the given function.
+	template <typename Func> [[nodiscard]] double time(Func &&func) {
+		auto begin = std::chrono::steady_clock::now();
+		func();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+}
+
+int main(int argc, char **argv) {
+	using namespace apigen::benchmark;
+
+	std::size_t overloads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+	std::size_t depth = std::max<std::size_t>(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4, 1);
+	std::size_t repetitions = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 5;
+
+	struct workload {
+		std::string name; ///< The name of this workload.
+		bool overloaded = true; ///< Whether all functions have the same name.
+		bool lazy = false; ///< Whether disambiguation postfixes are computed lazily.
+		bool unique = false; ///< Whether disambiguation postfixes are different for all overloads.
+	};
+	std::vector<workload> workloads{
+		{ "eager, unique postfixes", true, false, true },
+		{ "lazy, unique postfixes", true, true, true },
+		{ "eager, same postfix", true, false, false },
+		{ "lazy, same postfix", true, true, false },
+		{ "eager, no overloads", false, false, true },
+		{ "lazy, no overloads", false, true, true }
+	};
+
+	fmt::print("{} overloads across {} nested scopes, best of {} runs\n", overloads, depth, repetitions);
+	int status = 0;
+	for (const workload &work : workloads) {
+		double best = 0.0;
+		result res;
+		for (std::size_t i = 0; i < repetitions; ++i) {
+			double seconds = time([&]() {
+				res = allocate_overloads(overloads, depth, work.overloaded, work.lazy, work.unique);
+			});
+			best = i == 0 ? seconds : std::min(best, seconds);
+		}
+		fmt::print(
+			"{:<28}{:>10.3f} ms{:>10} postfixes computed{}\n",
+			work.name, best * 1000.0, res.postfixes_computed, res.names_unique ? "" : ", DUPLICATE NAMES"
+		);
+		if (!res.names_unique) {
+			status = 1;
+		}
+	}
+	return status;
+}
@@ -29,6 +29,8 @@
 
 #define APIGEN_ANNOTATION_PRIVATE_EXPORT        APIGEN_ANNOTATION_PREFIX "private_export"
 
+#define APIGEN_ANNOTATION_BATCH                 APIGEN_ANNOTATION_PREFIX "batch"
+
 #define APIGEN_ANNOTATION_RENAME                APIGEN_ANNOTATION_PREFIX "rename"
 #define APIGEN_ANNOTATION_RENAME_PREFIX         APIGEN_ANNOTATION_RENAME ":"
 #define APIGEN_ANNOTATION_ADOPT_NAME            APIGEN_ANNOTATION_PREFIX "adopt_name"
@@ -54,6 +56,9 @@ struct APIGEN_API_CLASS_NAME;
 
 #define APIGEN_PRIVATE_EXPORT            APIGEN_EXPORT APIGEN_ANNOTATE(APIGEN_ANNOTATION_PRIVATE_EXPORT)
 
+/// Also exports a variant of the function that takes arrays of arguments and calls the function for each element.
+#define APIGEN_BATCH                     APIGEN_ANNOTATE(APIGEN_ANNOTATION_BATCH)
+
 #define APIGEN_RENAME(NAME)              APIGEN_ANNOTATE(APIGEN_ANNOTATION_RENAME_PREFIX APIGEN_EXPAND_STR(NAME))
 #define APIGEN_ADOPT_NAME                APIGEN_ANNOTATE(APIGEN_ANNOTATION_ADOPT_NAME)
 
@@ -3,6 +3,11 @@
 /// \file
 /// Implementation of \ref apigen::basic_naming_convention.
 
+#include <deque>
+
+#include <llvm/ADT/DenseMap.h>
+
+#include "logger.h"
 #include "naming_convention.h"
 
 namespace apigen {
@@ -18,14 +23,18 @@ namespace apigen {
 		[[nodiscard]] name_info get_function_name(const entities::function_entity &entity) override {
 			return name_info(
 				std::string(_get_entity_name(entity.get_generic_declaration())),
-				_get_function_parameter_list_spelling(entity.get_declaration()->parameters())
+				[this, &entity]() {
+					return _get_function_parameter_list_spelling(entity.get_declaration()->parameters());
+				}
 			);
 		}
 		/// Returns the method name.
 		[[nodiscard]] name_info get_method_name(const entities::method_entity &entity) override {
 			return name_info(
 				std::string(_get_entity_name(entity.get_generic_declaration())),
-				_get_method_disambiguation(entity)
+				[this, &entity]() {
+					return _get_method_disambiguation(entity);
+				}
 			);
 		}
 		/// Returns the constructor name.
@@ -36,10 +45,20 @@ namespace apigen {
 				) +
 				std::string(scope_separator) + std::string(func_naming.constructor_name);
 			return name_info(
-				std::move(name), _get_function_parameter_list_spelling(entity.get_declaration()->parameters())
+				std::move(name),
+				[this, &entity]() {
+					return _get_function_parameter_list_spelling(entity.get_declaration()->parameters());
+				}
 			);
 		}
 
+		/// Returns the name of the function followed by \ref special_function_naming::batch_name.
+		[[nodiscard]] name_info get_function_batch_name(const entities::function_entity &entity) override {
+			name_info result = get_function_name_dynamic(entity);
+			result.name += std::string(scope_separator) + std::string(func_naming.batch_name);
+			return result;
+		}
+
 		/// Returns the type name.
 		[[nodiscard]] name_info get_user_type_name(const entities::user_type_entity &entity) override {
 			return name_info(std::string(_get_entity_name(entity.get_generic_declaration())), "");
@@ -55,6 +74,14 @@ namespace apigen {
 				std::string(func_naming.destructor_name);
 			return name_info(std::move(name), "");
 		}
+		/// Returns the exported name of the snapshot function of the given \ref entities::record_entity.
+		[[nodiscard]] name_info get_record_snapshot_name(const entities::record_entity &entity) override {
+			return name_info(_get_record_function_name(entity, func_naming.snapshot_name), "");
+		}
+		/// Returns the exported name of the apply function of the given \ref entities::record_entity.
+		[[nodiscard]] name_info get_record_apply_name(const entities::record_entity &entity) override {
+			return name_info(_get_record_function_name(entity, func_naming.apply_name), "");
+		}
 
 		/// Returns the name of an enumerator in the enum declaration.
 		[[nodiscard]] name_info get_enumerator_name(
@@ -69,25 +96,47 @@ namespace apigen {
 
 		/// Returns the exported name of the non-const getter of the given field.
 		[[nodiscard]] name_info get_field_getter_name(const entities::field_entity &entity) override {
-			// do not call _get_entity_name() on it directly since FieldDecl is not a DeclContext
-			std::string name =
-				std::string(_get_entity_name(entity.get_declaration()->getParent())) +
-				std::string(scope_separator) +
-				entity.get_declaration()->getName().str() +
-				std::string(scope_separator) +
-				std::string(func_naming.getter_name);
-			return name_info(std::move(name), "");
+			return name_info(_get_field_function_name(entity, func_naming.getter_name), "");
 		}
 		/// Returns the exportedname of the const getter of the given field.
 		[[nodiscard]] name_info get_field_const_getter_name(const entities::field_entity &entity) override {
-			// do not call _get_entity_name() on it directly since FieldDecl is not a DeclContext
-			std::string name =
-				std::string(_get_entity_name(entity.get_declaration()->getParent())) +
-				std::string(scope_separator) +
-				entity.get_declaration()->getName().str() +
-				std::string(scope_separator) +
-				std::string(func_naming.const_getter_name);
-			return name_info(std::move(name), "");
+			return name_info(_get_field_function_name(entity, func_naming.const_getter_name), "");
+		}
+		/// Returns the exported name of the function that copies the given array field out of an object.
+		[[nodiscard]] name_info get_field_copy_out_name(const entities::field_entity &entity) override {
+			return name_info(_get_field_function_name(entity, func_naming.copy_out_name), "");
+		}
+		/// Returns the exported name of the function that copies the given array field into an object.
+		[[nodiscard]] name_info get_field_copy_in_name(const entities::field_entity &entity) override {
+			return name_info(_get_field_function_name(entity, func_naming.copy_in_name), "");
+		}
+
+		/// Shortens the given identifier if it's longer than \ref max_name_length, keeping a readable prefix followed
+		/// by a stable hash of the whole spelling. This is called for every candidate that the name allocator tries,
+		/// so it has no side effects; hash collisions are resolved by the allocator like any other conflict.
+		[[nodiscard]] std::string shorten_name(std::string full) override {
+			if (max_name_length == 0 || full.size() <= max_name_length) {
+				return full;
+			}
+			constexpr static std::string_view _hex_digits = "0123456789abcdef";
+			std::uint64_t hash = stable_hash(full);
+			std::size_t hash_length = std::min<std::size_t>(name_hash_length, 16);
+			std::string hash_str(hash_length, '0');
+			for (std::size_t i = 0; i < hash_length; ++i) {
+				hash_str[i] = _hex_digits[(hash >> (60 - 4 * i)) & 0xF];
+			}
+			std::size_t suffix_length = hash_separator.size() + hash_length;
+			std::size_t prefix_length = max_name_length > suffix_length ? max_name_length - suffix_length : 0;
+			std::string result = full.substr(0, prefix_length);
+			if (!hash_separator.empty() && hash_separator.front() == '_') {
+				// avoid double underscores, which are reserved
+				while (result.size() > 1 && result.back() == '_') {
+					result.pop_back();
+				}
+			}
+			result += hash_separator;
+			result += hash_str;
+			return result;
 		}
 
 		special_function_naming func_naming; ///< Naming information of overloaded operators.
@@ -109,12 +158,78 @@ namespace apigen {
 			method_lvalue_ref{ "_ref" }, ///< Lvalue reference methods.
 			method_rvalue_ref{ "_rvalue_ref" }, ///< Rvalue reference methods.
 
-			function_type_begin{ "func_" }; ///< Prefix of function types.
+			function_type_begin{ "func_" }, ///< Prefix of function types.
+			vector_size_separator{ "_x" }, ///< Separates the element type and the size of vector types.
+
+			hash_separator{ "_" }; ///< Separates the prefix of a shortened name and the hash.
 		entity_registry *entities = nullptr; ///< All registered entities.
+		/// The maximum length of identifiers passed to \ref shorten_name(). Longer identifiers are truncated, and a
+		/// hash of the full spelling is appended to keep them unique. Zero indicates that there's no limit.
+		std::size_t max_name_length = 0;
+		/// The number of hexadecimal digits of the hash appended to shortened names. This must be between 1 and 16.
+		std::size_t name_hash_length = 8;
+
+		/// Checks that \ref max_name_length and \ref name_hash_length produce valid identifiers, and logs an error
+		/// for each problem.
+		[[nodiscard]] bool check_name_length_limits() const {
+			if (max_name_length == 0) {
+				return true;
+			}
+			if (name_hash_length == 0 || name_hash_length > 16) {
+				logger::get().log(
+					log_category::naming, log_level::error,
+					"the hash length of shortened names must be between 1 and 16, not {}", name_hash_length
+				);
+				return false;
+			}
+			if (max_name_length <= hash_separator.size() + name_hash_length) {
+				logger::get().log(
+					log_category::naming, log_level::error,
+					"the maximum name length {} leaves no room for a prefix before the separator and the {}-digit hash",
+					max_name_length, name_hash_length
+				);
+				return false;
+			}
+			return true;
+		}
 	protected:
+		/// Storage of all cached strings. A \p std::deque is used so that the strings are never relocated, and all
+		/// caches below can store \p std::string_view's that point into this container.
+		std::deque<std::string> _interned_strings;
 		/// Cached names of declarations, without its parent scopes.
-		std::map<clang::NamedDecl*, std::string> _decl_self_names;
-		std::map<clang::NamedDecl*, std::string> _decl_names; ///< Cached names of declarations.
+		llvm::DenseMap<clang::NamedDecl*, std::string_view> _decl_self_names;
+		llvm::DenseMap<clang::NamedDecl*, std::string_view> _decl_names; ///< Cached names of declarations.
+		/// Cached prefixes of scopes, i.e., the full names of the scopes followed by \ref scope_separator.
+		llvm::DenseMap<clang::NamedDecl*, std::string_view> _scope_prefixes;
+		/// Cached names of non-tag types.
+		llvm::DenseMap<const clang::Type*, std::string_view> _type_names;
+
+		/// Returns the name of a function associated with the given record, with the given suffix.
+		[[nodiscard]] std::string _get_record_function_name(
+			const entities::record_entity &entity, std::string_view suffix
+		) {
+			return
+				std::string(_get_entity_name(entity.get_declaration())) +
+				std::string(scope_separator) +
+				std::string(suffix);
+		}
+		/// Returns the name of a function associated with the given field, with the given suffix.
+		[[nodiscard]] std::string _get_field_function_name(
+			const entities::field_entity &entity, std::string_view suffix
+		) {
+			// do not call _get_entity_name() on it directly since FieldDecl is not a DeclContext
+			return
+				std::string(_get_entity_name(entity.get_declaration()->getParent())) +
+				std::string(scope_separator) +
+				entity.get_declaration()->getName().str() +
+				std::string(scope_separator) +
+				std::string(suffix);
+		}
+
+		/// Moves the given string into \ref _interned_strings and returns a view of it.
+		[[nodiscard]] std::string_view _intern(std::string str) {
+			return _interned_strings.emplace_back(std::move(str));
+		}
 
 		/// Appends short qualifiers to the given string.
 		inline static void _append_qualifiers(std::string &str, qualifier quals) {
@@ -158,7 +273,8 @@ namespace apigen {
 		[[nodiscard]] std::string _get_qualified_type_spelling(const qualified_type &type) {
 			std::string result;
 			_append_qualifiers_and_pointers(result, type.ref_kind, type.qualifiers);
-			return result + _get_type_name(type.type);
+			result += _get_type_name(type.type);
+			return result;
 		}
 		/// Returns the name of a single template argument to be used when exporting.
 		[[nodiscard]] std::string _get_template_argument_spelling(const clang::TemplateArgument &arg) {
@@ -186,7 +302,10 @@ namespace apigen {
 								c = 'd';
 								break;
 							default:
-								std::cerr << "unknown character in APSInt: " << result << "\n";
+								logger::get().log(
+									log_category::naming, log_level::warning,
+									"unknown character in APSInt: {}", result
+								);
 								c = '_';
 								break;
 							}
@@ -210,7 +329,8 @@ namespace apigen {
 			return "$UNSUPPORTED_TEMPLATE_ARG";
 		}
 		/// Returns the name of a template argument list to be used when exporting, without \ref template_args_begin
-		/// or \ref template_args_end.
+		/// or \ref template_args_end. This is not cached: it's computed once per specialization since the result is
+		/// part of the cached name of the specialization, and the spellings of type arguments are cached.
 		[[nodiscard]] std::string _get_template_argument_list_spelling(llvm::ArrayRef<clang::TemplateArgument> args) {
 			std::string result;
 			for (auto &&arg : args) {
@@ -225,74 +345,116 @@ namespace apigen {
 		/// Returns the name of the given entity without scope names.
 		[[nodiscard]] std::string_view _get_entity_self_name(clang::NamedDecl *decl) {
 			decl = llvm::cast<clang::NamedDecl>(decl->getCanonicalDecl());
-			auto it = _decl_self_names.find(decl);
-			if (it == _decl_self_names.end() || it->first != decl) {
-				std::string_view base_name;
-				if (auto *tag_decl = llvm::dyn_cast<clang::TagDecl>(decl)) {
-					base_name = _get_export_name<entities::user_type_entity>(
-						entities->find_or_register_parsed_entity(tag_decl)
-						);
-				} else if (auto *field_decl = llvm::dyn_cast<clang::FieldDecl>(decl)) {
-					base_name = _get_export_name<entities::field_entity>(
-						entities->find_or_register_parsed_entity(field_decl)
-						);
-				} else if (auto *function_decl = llvm::dyn_cast<clang::FunctionDecl>(decl)) {
-					auto *ent = cast<entities::function_entity>(
-						entities->find_or_register_parsed_entity(function_decl)
-						);
-					base_name = ent->get_substitute_name();
-					if (base_name.empty()) { // no user-defined name
-						if (function_decl->isOverloadedOperator()) { // operator
-							base_name = func_naming.get_operator_name(function_decl->getOverloadedOperator());
-						} else if (llvm::isa<clang::CXXConstructorDecl>(function_decl)) { // constructor
-							base_name = func_naming.constructor_name;
-						} else { // normal function
-							base_name = to_string_view(function_decl->getName());
-						}
+			if (auto it = _decl_self_names.find(decl); it != _decl_self_names.end()) {
+				return it->second;
+			}
+			std::string_view base_name;
+			if (auto *tag_decl = llvm::dyn_cast<clang::TagDecl>(decl)) {
+				base_name = _get_export_name<entities::user_type_entity>(
+					entities->find_or_register_parsed_entity(tag_decl)
+					);
+			} else if (auto *field_decl = llvm::dyn_cast<clang::FieldDecl>(decl)) {
+				base_name = _get_export_name<entities::field_entity>(
+					entities->find_or_register_parsed_entity(field_decl)
+					);
+			} else if (auto *function_decl = llvm::dyn_cast<clang::FunctionDecl>(decl)) {
+				auto *ent = cast<entities::function_entity>(
+					entities->find_or_register_parsed_entity(function_decl)
+					);
+				base_name = ent->get_substitute_name();
+				if (base_name.empty()) { // no user-defined name
+					if (function_decl->isOverloadedOperator()) { // operator
+						base_name = func_naming.get_operator_name(function_decl->getOverloadedOperator());
+					} else if (llvm::isa<clang::CXXConstructorDecl>(function_decl)) { // constructor
+						base_name = func_naming.constructor_name;
+					} else { // normal function
+						base_name = to_string_view(function_decl->getName());
 					}
-				} else {
-					base_name = to_string_view(decl->getName());
 				}
+			} else {
+				base_name = to_string_view(decl->getName());
+			}
 
-				std::string name(base_name);
-				if (auto *template_decl = llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(decl)) {
-					name +=
-						std::string(template_args_begin) +
-						_get_template_argument_list_spelling(template_decl->getTemplateArgs().asArray()) +
-						std::string(template_args_end);
-				}
-				it = _decl_self_names.emplace_hint(it, decl, std::move(name));
+			std::string name(base_name);
+			if (auto *template_decl = llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(decl)) {
+				name += template_args_begin;
+				name += _get_template_argument_list_spelling(template_decl->getTemplateArgs().asArray());
+				name += template_args_end;
 			}
-			return it->second;
+			std::string_view interned = _intern(std::move(name));
+			_decl_self_names.try_emplace(decl, interned);
+			return interned;
+		}
+		/// Returns the full name of the given scope followed by \ref scope_separator, or an empty string for the
+		/// translation unit. The result is composed from the cached prefix of the parent scope, so computing the
+		/// prefixes of all scopes takes linear time in the total length of the names.
+		[[nodiscard]] std::string_view _get_scope_prefix(clang::DeclContext *context) {
+			if (!context || context->isTranslationUnit()) {
+				return std::string_view();
+			}
+			auto *decl = llvm::cast<clang::NamedDecl>(llvm::cast<clang::NamedDecl>(context)->getCanonicalDecl());
+			if (auto it = _scope_prefixes.find(decl); it != _scope_prefixes.end()) {
+				return it->second;
+			}
+			std::string_view
+				parent_prefix = _get_scope_prefix(llvm::cast<clang::DeclContext>(decl)->getParent()),
+				self_name = _get_entity_self_name(decl);
+			std::string result;
+			result.reserve(parent_prefix.size() + self_name.size() + scope_separator.size());
+			result += parent_prefix;
+			result += self_name;
+			result += scope_separator;
+			std::string_view interned = _intern(std::move(result));
+			_scope_prefixes.try_emplace(decl, interned);
+			return interned;
 		}
 		/// Returns the full name of the given entity, including all its parent scopes.
 		[[nodiscard]] std::string_view _get_entity_name(clang::NamedDecl *decl) {
 			decl = llvm::cast<clang::NamedDecl>(decl->getCanonicalDecl());
-			auto it = _decl_names.lower_bound(decl);
-			if (it == _decl_names.end() || it->first != decl) {
-				std::string result;
-				for (
-					auto *context = llvm::cast<clang::DeclContext>(decl);
-					context && !context->isTranslationUnit();
-					context = context->getParent()
-					) {
-					if (!result.empty()) {
-						result = std::string(scope_separator) + result;
-					}
-					result = std::string(_get_entity_self_name(llvm::cast<clang::NamedDecl>(context))) + result;
+			if (auto it = _decl_names.find(decl); it != _decl_names.end()) {
+				return it->second;
+			}
+			std::string_view result;
+			std::string_view self_name = _get_entity_self_name(decl);
+			clang::DeclContext *parent = llvm::cast<clang::DeclContext>(decl)->getParent();
+			if (self_name.empty()) {
+				// no separator is added after parent scopes for unnamed declarations
+				if (parent && !parent->isTranslationUnit()) {
+					result = _get_entity_name(llvm::cast<clang::NamedDecl>(parent));
+				}
+			} else {
+				std::string_view prefix = _get_scope_prefix(parent);
+				if (prefix.empty()) {
+					result = self_name;
+				} else {
+					std::string name;
+					name.reserve(prefix.size() + self_name.size());
+					name += prefix;
+					name += self_name;
+					result = _intern(std::move(name));
 				}
-				it = _decl_names.emplace_hint(it, decl, std::move(result));
 			}
-			return it->second;
+			_decl_names.try_emplace(decl, result);
+			return result;
 		}
 		/// Returns the exported name for the given \p clang::Type.
-		[[nodiscard]] std::string _get_type_name(const clang::Type *type) {
+		[[nodiscard]] std::string_view _get_type_name(const clang::Type *type) {
 			if (auto *builtin = llvm::dyn_cast<clang::BuiltinType>(type)) {
-				return builtin->getName(printing_policy);
+				// builtin type names are static strings
+				return to_string_view(builtin->getName(printing_policy));
 			}
 			if (auto *tag = llvm::dyn_cast<clang::TagType>(type)) {
-				return std::string(_get_entity_name(tag->getAsTagDecl()));
+				return _get_entity_name(tag->getAsTagDecl());
 			}
+			if (auto it = _type_names.find(type); it != _type_names.end()) {
+				return it->second;
+			}
+			std::string_view result = _intern(_get_uncached_type_name(type));
+			_type_names.try_emplace(type, result);
+			return result;
+		}
+		/// Computes the exported name of a non-builtin and non-tag type.
+		[[nodiscard]] std::string _get_uncached_type_name(const clang::Type *type) {
 			if (auto *functy = llvm::dyn_cast<clang::FunctionProtoType>(type)) {
 				std::stringstream ss;
 				ss <<
@@ -316,6 +478,11 @@ namespace apigen {
 				}
 				return ss.str();
 			}
+			if (auto *vecty = llvm::dyn_cast<clang::VectorType>(type)) {
+				return
+					std::string(_get_type_name(vecty->getElementType().getCanonicalType().getTypePtr())) +
+					std::string(vector_size_separator) + std::to_string(vecty->getNumElements());
+			}
 			return "$UNSUPPORTED_TYPE";
 		}
 
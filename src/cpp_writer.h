@@ -3,11 +3,19 @@
 /// \file
 /// Contains the \ref apigen::cpp_writer class.
 
+#include <algorithm>
 #include <vector>
+#include <deque>
+#include <functional>
 #include <set>
+#include <unordered_map>
 #include <ostream>
 #include <string_view>
 #include <variant>
+#include <iterator>
+#include <type_traits>
+
+#include <fmt/format.h>
 
 #include "internal_name_printer.h"
 
@@ -29,8 +37,13 @@ namespace apigen {
 			replace_invalid_identifier_characters_in(s);
 			return s;
 		}
+		/// A function that maps the composed spelling of a name to the identifier that's actually used.
+		using shortener = std::function<std::string(std::string)>;
 		/// Information of a single named entity.
 		struct name_info {
+			/// A function that computes the disambiguation postfix.
+			using disambiguation_producer = std::function<std::string()>;
+
 			/// Default constructor.
 			name_info() = default;
 			/// Initializes all fields of this struct.
@@ -39,26 +52,58 @@ namespace apigen {
 				replace_invalid_identifier_characters_in(name);
 				replace_invalid_identifier_characters_in(disambiguation_postfix);
 			}
+			/// Initializes the name and the function that computes the disambiguation postfix.
+			name_info(std::string n, disambiguation_producer producer) :
+				name(std::move(n)), lazy_disambiguation_postfix(std::move(producer)) {
+				replace_invalid_identifier_characters_in(name);
+			}
 
+			/// Computes \ref disambiguation_postfix if necessary, and sets \ref postfix_used.
+			void use_disambiguation_postfix() {
+				if (lazy_disambiguation_postfix) {
+					disambiguation_postfix = lazy_disambiguation_postfix();
+					replace_invalid_identifier_characters_in(disambiguation_postfix);
+					lazy_disambiguation_postfix = nullptr;
+				}
+				postfix_used = true;
+			}
+
+			/// Returns the composited name before \ref shorten is applied.
+			[[nodiscard]] std::string get_full_name() const {
+				std::string result = name;
+				if (postfix_used) {
+					result += disambiguation_postfix;
+					if (numbering != 0) {
+						// TODO add some sort of separator?
+						result += std::to_string(numbering);
+					}
+				}
+				return result;
+			}
 			/// Returns the final composited name.
 			[[nodiscard]] std::string get_name() const {
-				if (!postfix_used) {
-					return name;
+				if (shorten) {
+					return shorten(get_full_name());
 				}
-				if (numbering == 0) {
-					return name + disambiguation_postfix;
-				}
-				// TODO add some sort of separator?
-				return name + disambiguation_postfix + std::to_string(numbering);
+				return get_full_name();
 			}
 
 			std::string
 				name, ///< The name of this object.
 				disambiguation_postfix; ///< The postfix that is used for disambiguation.
+			/// If non-empty, this function is called to compute \ref disambiguation_postfix the first time it's
+			/// needed.
+			disambiguation_producer lazy_disambiguation_postfix;
 			/// The numbering appended to this name when there're still conflicts after appending the postfix to this
 			/// name. If this is zero, there's no numbering for this entity.
 			std::size_t numbering = 0;
 			bool postfix_used = false; ///< Whether \ref disambiguation_postfix is used in this name.
+			/// Whether this name must be used as-is. Names that conflict with a fixed name are always the ones that
+			/// get renamed.
+			bool fixed = false;
+			/// If non-empty, this function is applied to the composited name in \ref get_name(). This is taken from
+			/// \ref name_allocator::name_shortener when the name is allocated.
+			shortener shorten;
 		};
 		using token = std::unique_ptr<name_info>; ///< The token returned to the caller.
 
@@ -71,34 +116,35 @@ namespace apigen {
 		/// \param name The shorter name of the object that will be used if there are no conflicts.
 		/// \param disambig The postfix that would be appended to the name to try and resolve conflicts.
 		token allocate_variable_custom(std::string name, std::string disambig) {
-			auto token = std::make_unique<name_info>(std::move(name), std::move(disambig));
-			bool occupied = false;
-			if (is_immutable_mode()) {
-				occupied = _is_name_occupied(token->name);
-			} else {
-				auto &&[scope, it] = _find_occupied_name(token->name);
-				if (scope) {
-					if (it->second) {
-						name_info *occupant = it->second;
-						it->second = nullptr;
-						_resolve_first_level_conflict(occupant);
-					}
-					occupied = true;
-				}
-			}
-			if (occupied) { // resolve first level name conflicts
-				_resolve_first_level_conflict(token.get());
-			} else {
-				_names.emplace(token->get_name(), token.get());
+			return _allocate(std::make_unique<name_info>(std::move(name), std::move(disambig)));
+		}
+		/// \overload
+		///
+		/// \param name The shorter name of the object that will be used if there are no conflicts.
+		/// \param disambig Function that computes the postfix. This function is only called if there are conflicts.
+		token allocate_variable_custom(std::string name, name_info::disambiguation_producer disambig) {
+			return _allocate(std::make_unique<name_info>(std::move(name), std::move(disambig)));
+		}
+		/// Registers a name that must be used as-is, for example a name that has been assigned in a previous run.
+		/// Fixed names should be registered before all other names. If the name is already occupied, or if
+		/// \ref name_shortener would change it, this function falls back to \ref allocate_variable_custom().
+		token allocate_fixed(std::string name) {
+			auto tok = std::make_unique<name_info>(std::move(name), std::string());
+			if (_is_name_occupied(tok->name) || !_is_within_length_limit(tok->name)) {
+				return _allocate(std::move(tok));
 			}
-			return token;
+			tok->fixed = true;
+			_register_name(tok->name, tok.get());
+			return tok;
 		}
 		/// Tries to register a variable name with a prefix.
-		token allocate_variable_prefix(std::string_view prefix, std::string name, std::string disambig) {
+		template <typename Disambig> token allocate_variable_prefix(
+			std::string_view prefix, std::string name, Disambig &&disambig
+		) {
 			if (name.empty()) {
 				name = "unnamed";
 			}
-			return allocate_variable_custom(std::string(prefix) + std::move(name), std::move(disambig));
+			return allocate_variable_custom(std::string(prefix) + std::move(name), std::forward<Disambig>(disambig));
 		}
 
 		/// Allocates the name for a function parameter.
@@ -110,6 +156,11 @@ namespace apigen {
 			return allocate_variable_prefix("_apigen_priv_local_", std::move(name), std::move(disambig));
 		}
 
+		/// If non-empty, this function is applied to the composited names allocated by this allocator. Fixed names are
+		/// never changed by it; they're allocated as normal names instead if they're too long. This is not inherited
+		/// by child scopes, and is ignored in immutable mode, where names are allocated concurrently.
+		shortener name_shortener;
+
 		/// Indicates whether names allocated by this allocator can be changed afterwards.
 		[[nodiscard]] bool is_immutable_mode() const {
 			return std::holds_alternative<const name_allocator*>(_parent);
@@ -124,12 +175,42 @@ namespace apigen {
 			return name_allocator(std::in_place_type<const name_allocator*>, &alloc);
 		}
 	protected:
-		/// The mapping between names and tokens.
-		using _name_mapping = std::map<std::string, name_info*, std::less<void>>;
+		/// Registers the given name, resolving conflicts if necessary.
+		token _allocate(token tok) {
+			bool occupied = false;
+			if (is_immutable_mode()) {
+				occupied = _is_name_occupied(tok->get_name());
+			} else {
+				tok->shorten = name_shortener;
+				auto &&[scope, it] = _find_occupied_name(tok->get_name());
+				if (scope) {
+					if (it->second && !it->second->fixed) {
+						name_info *occupant = it->second;
+						it->second = nullptr;
+						_resolve_first_level_conflict(occupant);
+					}
+					occupied = true;
+				}
+			}
+			if (occupied) { // resolve first level name conflicts
+				_resolve_first_level_conflict(tok.get());
+			} else {
+				_register_name(tok->get_name(), tok.get());
+			}
+			return tok;
+		}
+
+		/// The mapping between names and tokens. Keys point to strings in \ref _name_storage.
+		using _name_mapping = std::unordered_map<std::string_view, name_info*>;
 
 		/// All registered variable names. If a name is `conflicted', it will still exist but the pointer will be
 		/// empty.
 		_name_mapping _names;
+		/// Storage of all names in \ref _names. A \p std::deque is used so that the strings are never relocated.
+		std::deque<std::string> _name_storage;
+		/// The next number to try for each combination of a name and a disambiguation postfix, so that numbering
+		/// overloads of the same name does not start from 1 every time. See benchmark/name_allocator_benchmark.cpp.
+		std::unordered_map<std::string, std::size_t> _next_numbering;
 		/// The \ref name_allocator for the parent scope.
 		std::variant<name_allocator*, const name_allocator*> _parent;
 
@@ -165,16 +246,30 @@ namespace apigen {
 			return {nullptr, _name_mapping::iterator()};
 		}
 
+		/// Checks that \ref name_shortener would keep the given name as-is.
+		[[nodiscard]] bool _is_within_length_limit(const std::string &name) const {
+			return is_immutable_mode() || !name_shortener || name_shortener(name) == name;
+		}
+		/// Adds the given name to \ref _names. The name must not already be registered in this scope.
+		void _register_name(std::string name_str, name_info *name) {
+			std::string_view key = _name_storage.emplace_back(std::move(name_str));
+			_names.emplace(key, name);
+		}
+
 		/// Resolves the conflict of disambiguated names by appending a number to the name.
 		void _resolve_second_level_conflict(name_info *name) {
 			if (name->numbering == 0) {
-				for (name->numbering = 1; ; ++name->numbering) {
+				name->use_disambiguation_postfix();
+				std::string base = name->name + name->disambiguation_postfix;
+				std::size_t &next = _next_numbering.try_emplace(base, 1).first->second;
+				for (name->numbering = next; ; ++name->numbering) {
 					std::string name_str = name->get_name();
 					if (!_is_name_occupied(name_str)) {
-						_names.emplace(std::move(name_str), name);
+						_register_name(std::move(name_str), name);
 						break;
 					}
 				}
+				next = name->numbering + 1;
 			} // otherwise this is an already existing name, and the conflict will be resolved by the new name
 		}
 		/// Resolves the conflict of base names by appending the disambiguation postfix to the name.
@@ -182,7 +277,7 @@ namespace apigen {
 			if (name->postfix_used) {
 				_resolve_second_level_conflict(name);
 			} else {
-				name->postfix_used = true;
+				name->use_disambiguation_postfix();
 				std::string name_str = name->get_name();
 				bool occupied = false;
 				if (is_immutable_mode()) {
@@ -190,7 +285,7 @@ namespace apigen {
 				} else {
 					auto &&[scope, ent] = _find_occupied_name(name_str);
 					if (scope) {
-						if (ent->second) {
+						if (ent->second && !ent->second->fixed) {
 							_resolve_second_level_conflict(ent->second);
 							ent->second = nullptr;
 						}
@@ -200,7 +295,7 @@ namespace apigen {
 				if (occupied) { // try to resolve second level conflict
 					_resolve_second_level_conflict(name);
 				} else { // otherwise register the name for now
-					_names.emplace(std::move(name_str), name);
+					_register_name(std::move(name_str), name);
 				}
 			}
 		}
@@ -224,9 +319,24 @@ namespace apigen {
 			parentheses_scope{"(", ")"}, ///< A scope surrounded by parentheses.
 			braces_scope{"{", "}"}; ///< A scope surrounded by brackets.
 
+		/// The number of buffered bytes that triggers a write to the output stream. Measured with
+		/// benchmark/cpp_writer_benchmark.cpp, throughput is the same for thresholds between 256 KiB and 4 MiB, while
+		/// keeping a whole multi-megabyte file in memory is slower; this value keeps the memory used by concurrent
+		/// writers small.
+		constexpr static std::size_t flush_threshold = 1024 * 1024;
+
 		/// Initializes \ref _out.
 		explicit cpp_writer(std::ostream &out, clang::PrintingPolicy policy) :
-			name_printer(std::move(policy)), _out(out) {
+			name_printer(std::move(policy)), _out(&out) {
+		}
+		/// Initializes a writer that keeps all contents in memory, and starts with the given level of indentation.
+		/// The contents can be retrieved using \ref get_buffered_contents().
+		explicit cpp_writer(clang::PrintingPolicy policy, std::size_t indent = 0) :
+			name_printer(std::move(policy)), _indent(indent) {
+		}
+		/// Writes all remaining contents to the output stream.
+		~cpp_writer() {
+			flush();
 		}
 		/// No move construction.
 		cpp_writer(cpp_writer&&) = delete;
@@ -281,25 +391,37 @@ namespace apigen {
 		/// Directly writes the given object to the output.
 		template <typename T> cpp_writer &write(T &&obj) {
 			_maybe_print_sepearator();
-			_out << std::forward<T>(obj);
+			if constexpr (std::is_convertible_v<T, std::string_view>) {
+				_append(std::string_view(obj));
+			} else if constexpr (std::is_same_v<std::decay_t<T>, char>) {
+				_buffer.push_back(obj);
+			} else {
+				fmt::format_to(std::back_inserter(_buffer), "{}", std::forward<T>(obj));
+			}
+			_maybe_flush();
 			return *this;
 		}
 		/// Uses \p fmt to format and write to the output stream.
 		template <typename ...Args> cpp_writer &write_fmt(Args &&...args) {
 			_maybe_print_sepearator();
-			fmt::print(_out, std::forward<Args>(args)...);
+			fmt::format_to(std::back_inserter(_buffer), std::forward<Args>(args)...);
+			_maybe_flush();
 			return *this;
 		}
 		/// Starts a new line.
 		cpp_writer &new_line() {
-			write("\n");
+			_maybe_print_sepearator();
+			_buffer.push_back('\n');
 			if (!_scopes.empty() && !_scopes.back().has_newline) {
 				++_indent;
 				_scopes.back().has_newline = true;
 			}
-			for (std::size_t i = 0; i < _indent; ++i) {
-				write("\t");
+			for (std::size_t i = _indent; i > 0; ) {
+				std::size_t count = std::min(i, _tabs.size());
+				_append(_tabs.substr(0, count));
+				i -= count;
 			}
+			_maybe_flush();
 			return *this;
 		}
 		/// Pushes a scope onto \ref _scopes and starts that scope.
@@ -316,8 +438,28 @@ namespace apigen {
 			return *this;
 		}
 
+		/// Writes all buffered contents to the output stream. This has no effect for in-memory writers.
+		void flush() {
+			if (_out && _buffer.size() > 0) {
+				_out->write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+				_buffer.clear();
+			}
+		}
+		/// Returns the contents that have not been written to the output stream.
+		[[nodiscard]] std::string_view get_buffered_contents() const {
+			return std::string_view(_buffer.data(), _buffer.size());
+		}
+
+		/// Returns the level of indentation of the current line.
+		[[nodiscard]] std::size_t get_indent() const {
+			return _indent;
+		}
+
 		internal_name_printer name_printer; ///< The \ref internal_name_printer.
 	protected:
+		/// Tabs used for indentation, so that a whole line of indentation can be appended at once.
+		constexpr static std::string_view _tabs = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+
 		/// Records the state of a scope.
 		struct _scope_rec {
 			/// Default constructor.
@@ -330,10 +472,20 @@ namespace apigen {
 			bool has_newline = false; ///< Whether or not a new line has been written in this scope.
 		};
 
+		/// Appends the given string to \ref _buffer.
+		void _append(std::string_view str) {
+			_buffer.append(str.data(), str.data() + str.size());
+		}
+		/// Calls \ref flush() if the buffer is larger than \ref flush_threshold.
+		void _maybe_flush() {
+			if (_out && _buffer.size() >= flush_threshold) {
+				flush();
+			}
+		}
 		/// Prints and clears the separator if it's not empty.
 		void _maybe_print_sepearator() {
 			if (!_separator.empty()) {
-				_out << _separator;
+				_append(_separator);
 				_separator = std::string_view();
 			}
 		}
@@ -350,7 +502,8 @@ namespace apigen {
 
 		std::vector<_scope_rec> _scopes; ///< All current scopes.
 		std::string_view _separator; ///< The pending separator.
-		std::ostream &_out; ///< The output.
+		fmt::memory_buffer _buffer; ///< Contents that have not been written to \ref _out.
+		std::ostream *_out = nullptr; ///< The output, or \p nullptr if all contents are kept in memory.
 		std::size_t _indent = 0; ///< The level of indentation.
 	};
 }
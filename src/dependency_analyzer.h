@@ -4,9 +4,9 @@
 /// Used when analyzing the dependency between entities.
 
 #include <stack>
-#include <iostream>
 
 #include "entity.h"
+#include "logger.h"
 
 namespace apigen {
 	class entity_registry;
@@ -23,7 +23,12 @@ namespace apigen {
 		}
 		/// Queues the given entity without checking if it has already been marked.
 		void queue(entity &ent) {
-			std::cerr << "exporting: " << ent.get_generic_declaration()->getQualifiedNameAsString() << "\n";
+			if (logger &log = logger::get(); log.is_enabled(log_category::dependency, log_level::debug)) {
+				log.log(
+					log_category::dependency, log_level::debug,
+					"exporting: {}", ent.get_generic_declaration()->getQualifiedNameAsString()
+				);
+			}
 			_queue.emplace(&ent);
 		}
 
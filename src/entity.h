@@ -9,6 +9,7 @@
 #include <clang/AST/Attr.h>
 
 #include "apigen_definitions.h"
+#include "logger.h"
 #include "misc.h"
 #include "naming_convention.h"
 
@@ -73,7 +74,10 @@ namespace apigen {
 			if (TEMP_starts_with(APIGEN_ANNOTATION_RENAME_PREFIX, attr)) {
 				attr.remove_prefix(std::strlen(APIGEN_ANNOTATION_RENAME_PREFIX));
 				if (!_substitute_name.empty() && _substitute_name != attr) {
-					std::cerr << attr << ": conflicts with existing substitute name " << _substitute_name << "\n";
+					logger::get().log(
+						log_category::parsing, log_level::warning,
+						"{}: conflicts with existing substitute name {}", attr, _substitute_name
+					);
 				}
 				_substitute_name = attr;
 				return true;
@@ -87,7 +91,9 @@ namespace apigen {
 					llvm::StringRef attr_llvm = anno_attr->getAnnotation();
 					std::string_view attr_str(attr_llvm.data(), attr_llvm.size());
 					if (!handle_attribute(attr_str)) {
-						std::cerr << "unknown annotation " << attr_str << "\n";
+						logger::get().log(
+							log_category::parsing, log_level::warning, "unknown annotation {}", attr_str
+						);
 					}
 				}
 			}
@@ -14,10 +14,18 @@ namespace apigen::entities {
 			queue.try_queue(*_type.type_entity);
 		}
 		queue.try_queue(*_parent);
+		if (_type.is_array()) { // arrays are copied using std::memcpy()
+			reg.register_custom_host_dependency("cstring");
+		}
+		auto *parent_decl = llvm::dyn_cast<clang::CXXRecordDecl>(_decl->getParent());
+		// offsets of fields of standard-layout records are checked using offsetof
+		if (parent_decl && !parent_decl->isDependentType() && parent_decl->isStandardLayout()) {
+			reg.register_custom_host_dependency("cstddef");
+		}
 
 		if (_type.ref_kind != reference_kind::none) {
 			_field_kind = field_kind::reference_field;
-		} else if ((_type.qualifiers.front() & qualifier::const_qual) != qualifier::none) {
+		} else if ((_type.get_element_qualifiers() & qualifier::const_qual) != qualifier::none) {
 			_field_kind = field_kind::const_field;
 		} else if (_decl->isMutable()) {
 			_field_kind = field_kind::mutable_field;
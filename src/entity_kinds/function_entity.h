@@ -53,6 +53,19 @@ namespace apigen::entities {
 			}
 		}
 
+		/// Handles the \p apigen_batch attribute.
+		bool handle_attribute(std::string_view anno) override {
+			if (anno == APIGEN_ANNOTATION_BATCH) {
+				_batch = true;
+				return true;
+			}
+			return entity::handle_attribute(anno);
+		}
+
+		/// Returns whether a batch variant of this function should be exported.
+		[[nodiscard]] bool is_batched() const {
+			return _batch;
+		}
 		/// Returns the list of parameters.
 		[[nodiscard]] const std::vector<parameter_info> &get_parameters() const {
 			return _parameters;
@@ -80,6 +93,7 @@ namespace apigen::entities {
 		std::vector<parameter_info> _parameters; ///< Information about all parameters.
 		std::string _export_name; ///< The actual name used when exporting.
 		clang::FunctionDecl *_decl = nullptr; ///< The \p clang::FunctionDecl.
+		bool _batch = false; ///< Whether a batch variant of this function should be exported.
 
 		/// Populates \ref _parameters with the set of parameters the exported function should have.
 		virtual void _build_parameter_list(entity_registry &reg) {
@@ -50,7 +50,7 @@ namespace apigen::entities {
 		writer.write_fmt("{} ", ex.get_exported_type_name(qty.type, qty.type_entity));
 		if (qty.is_reference_or_pointer()) {
 			exporter::export_api_pointers_and_qualifiers(writer, qty.ref_kind, qty.qualifiers);
-		} else {
+		} else if (!ex.is_passed_by_value(qty)) {
 			if (auto *complex_ty = dyn_cast<entities::record_entity>(qty.type_entity)) { // temporary object
 				if (mark_temp) {
 					// an empty marker that indicates this parameter is a temporary object
@@ -69,7 +69,7 @@ namespace apigen::entities {
 			_export_parameter_type(writer, ex, qty, mark_temp);
 			writer.maybe_separate(", ");
 		}
-		if (_return_type.is_record_type()) {
+		if (_return_type.is_record_type() && !ex.is_passed_by_value(_return_type)) {
 			// additional input pointing to the memory block that receives the return value
 			writer
 				.write("void*")
@@ -98,9 +98,10 @@ namespace apigen::entities {
 					writer.write_fmt("{})", *param_it);
 				} else {
 					if (auto *recty = dyn_cast<entities::record_entity>(qty.type_entity)) { // record
-						// simply cast & pass the pointer to the function
+						// simply cast & pass the pointer to the function, dereferencing it if passed by value
 						writer.write_fmt(
-							"reinterpret_cast<{}*>(&{})",
+							"{}reinterpret_cast<{}*>(&{})",
+							ex.is_passed_by_value(qty) ? "*" : "",
 							ex.get_record_names().at(recty).name.get_cached(), *param_it
 						);
 					} else { // primitive types
@@ -116,7 +117,7 @@ namespace apigen::entities {
 				writer.maybe_separate(", ");
 				++param_it;
 			}
-			if (_return_type.is_record_type()) { // complex return type
+			if (_return_type.is_record_type() && !ex.is_passed_by_value(_return_type)) { // complex return type
 				writer
 					.write(output)
 					.maybe_separate(", ");
@@ -155,7 +156,7 @@ namespace apigen::entities {
 		name_allocator::token fptr_token, ret_ptr_token, user_data_token;
 		std::string fptr_name, ret_ptr_name, user_data_name;
 
-		bool complex_return = _return_type.is_record_type();
+		bool complex_return = _return_type.is_record_type() && !ex.is_passed_by_value(_return_type);
 		std::string_view api_func_type = ex.get_record_names().at(&_entity).name.get_cached();
 		writer.write_fmt("inline static {} *{}", api_func_type, name);
 		{ // function parameters
@@ -217,7 +218,19 @@ namespace apigen::entities {
 				auto body_scope = writer.begin_scope(cpp_writer::braces_scope);
 
 				writer.new_line();
-				if (complex_return) {
+				if (ex.is_passed_by_value(_return_type)) {
+					// store the API struct in a local variable and reinterpret it as the internal type
+					name_allocator::token return_token = body_alloc.allocate_local_variable("result", "");
+					writer.write_fmt("auto {} = ", return_token->get_name());
+					_export_function_call(writer, ex, fptr_name, param_names, "", user_data_name);
+					writer
+						.write(";")
+						.new_line()
+						.write_fmt(
+							"return *reinterpret_cast<{}*>(&{});",
+							writer.name_printer.get_internal_type_name(_return_type.type), return_token->get_name()
+						);
+				} else if (complex_return) {
 					name_allocator::token return_mem_token, return_ptr_token, return_token;
 					std::string return_mem_name, return_ptr_name, return_name;
 					return_mem_token = body_alloc.allocate_local_variable("result_mem", "");
@@ -109,6 +109,10 @@ namespace apigen::entities {
 			// TODO private members that are explicitly marked as export will still be exported
 			return _private_export;
 		}
+		/// Returns whether all members of this class are exported.
+		[[nodiscard]] bool is_recursive() const {
+			return _recursive;
+		}
 		/// Returns whether or not this class has a viable move constructor.
 		[[nodiscard]] bool has_move_constructor() const {
 			return _move_constructor;
@@ -3,7 +3,442 @@
 /// \file
 /// Implementation of actual exporting the entities.
 
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
 namespace apigen {
+	// naming
+	std::vector<entity*> exporter::_get_exported_entities_in_declaration_order(const entity_registry &reg) {
+		struct _sort_entry {
+			entity *ent = nullptr;
+			clang::SourceLocation location;
+			std::string usr;
+		};
+		std::vector<_sort_entry> entries;
+		for (auto &&[decl, ent_ptr] : reg.get_entities()) {
+			if (ent_ptr->is_marked_for_exporting()) {
+				entries.push_back({ ent_ptr.get(), decl->getLocation(), name_ledger::get_usr(decl) });
+			}
+		}
+		if (!entries.empty()) {
+			const clang::SourceManager &manager = reg.get_entities().begin()->first->getASTContext().getSourceManager();
+			// entities without valid locations (e.g., builtins) come first
+			std::sort(entries.begin(), entries.end(), [&manager](const _sort_entry &lhs, const _sort_entry &rhs) {
+				if (lhs.location.isValid() != rhs.location.isValid()) {
+					return rhs.location.isValid();
+				}
+				if (lhs.location.isValid() && lhs.location != rhs.location) {
+					return manager.isBeforeInTranslationUnit(lhs.location, rhs.location);
+				}
+				return lhs.usr < rhs.usr;
+			});
+		}
+		std::vector<entity*> result;
+		result.reserve(entries.size());
+		for (auto &entry : entries) {
+			result.emplace_back(entry.ent);
+		}
+		return result;
+	}
+
+	std::string_view exporter::get_top_level_namespace(const clang::Decl *decl) {
+		const clang::NamespaceDecl *result = nullptr;
+		for (const clang::DeclContext *ctx = decl->getDeclContext(); ctx; ctx = ctx->getParent()) {
+			if (auto *ns = llvm::dyn_cast<clang::NamespaceDecl>(ctx)) {
+				result = ns;
+			}
+		}
+		if (result && !result->isAnonymousNamespace()) {
+			return to_string_view(result->getName());
+		}
+		return std::string_view();
+	}
+
+	void exporter::_collect_api_groups(const std::vector<entity*> &exported) {
+		for (entity *ent : exported) {
+			std::string_view group;
+			if (auto *func_entity = dyn_cast<entities::function_entity>(ent)) {
+				group = _get_api_group(func_entity);
+			} else if (auto *field_entity = dyn_cast<entities::field_entity>(ent)) {
+				group = _get_api_group(field_entity);
+			} else if (auto *record_entity = dyn_cast<entities::record_entity>(ent)) {
+				group = _get_api_group(record_entity);
+			}
+			if (!group.empty() && _api_groups.find(group) == _api_groups.end()) {
+				_api_groups.emplace(std::string(group), api_group_naming());
+			}
+		}
+		for (auto &&[group, name] : _api_groups) {
+			name.struct_name = cached_name(_global_scope.allocate_variable_custom(
+				std::string(naming->api_struct_name) + "_" + group, std::string()
+			));
+			// function pointers of global functions are allocated in the global scope, so are the sub-table members
+			name.member_name = cached_name(_global_scope.allocate_variable_custom(group, std::string()));
+		}
+	}
+
+	std::string exporter::_get_api_table_member_prefix(std::string_view group) const {
+		if (group.empty()) {
+			return std::string();
+		}
+		return std::string(_api_groups.find(group)->second.member_name.get_cached()) + ".";
+	}
+
+	void exporter::_reserve_ledger_names(const entity_registry &reg, name_allocator &api_table_scope) {
+		// collect USRs of all exported declarations
+		std::set<std::string, std::less<>> live_usrs;
+		auto add_usr = [&live_usrs](const clang::Decl *decl) {
+			if (std::string usr = name_ledger::get_usr(decl); !usr.empty()) {
+				live_usrs.emplace(std::move(usr));
+			}
+		};
+		for (auto &&[_, ent_ptr] : reg.get_entities()) {
+			if (!ent_ptr->is_marked_for_exporting()) {
+				continue;
+			}
+			entity *ent = ent_ptr.get();
+			if (auto *func_entity = dyn_cast<entities::function_entity>(ent)) {
+				add_usr(func_entity->get_declaration());
+			} else if (auto *field_entity = dyn_cast<entities::field_entity>(ent)) {
+				add_usr(field_entity->get_declaration());
+			} else if (auto *enum_entity = dyn_cast<entities::enum_entity>(ent)) {
+				add_usr(enum_entity->get_declaration());
+				for (clang::EnumConstantDecl *enumerator : enum_entity->get_declaration()->enumerators()) {
+					add_usr(enumerator);
+				}
+			} else if (auto *record_entity = dyn_cast<entities::record_entity>(ent)) {
+				add_usr(record_entity->get_declaration());
+			}
+		}
+
+		// reserve the names in the scopes they were allocated in
+		for (auto &&[key, name] : ledger->get_previous()) {
+			auto [usr, role] = name_ledger::split_key(key);
+			if (live_usrs.find(usr) == live_usrs.end()) {
+				continue;
+			}
+			name_allocator *scope = nullptr;
+			if (role == _role_api || role == _role_type || role == _role_enumerator || role == _role_batch) {
+				scope = &_global_scope;
+			} else if (
+				role == _role_getter || role == _role_const_getter || role == _role_dtor ||
+				role == _role_copy_out || role == _role_copy_in || role == _role_snapshot || role == _role_apply
+			) {
+				scope = &api_table_scope;
+			} else if (
+				role == _role_impl || role == _role_batch_impl || role == _role_getter_impl ||
+				role == _role_const_getter_impl || role == _role_dtor_impl ||
+				role == _role_copy_out_impl || role == _role_copy_in_impl ||
+				role == _role_snapshot_impl || role == _role_apply_impl
+			) {
+				scope = &_impl_scope;
+			} else {
+				logger::get().log(
+					log_category::naming, log_level::warning, "unknown role in name ledger entry: {}", key
+				);
+				continue;
+			}
+			if (scope->name_shortener && scope->name_shortener(name) != name) {
+				// allocate_fixed() shortens the name like a new one
+				logger::get().log(
+					log_category::naming, log_level::warning,
+					"name {} recorded for {} exceeds the maximum name length and is shortened", name, key
+				);
+			}
+			_reserved_names.insert_or_assign(key, scope->allocate_fixed(name));
+		}
+	}
+
+	exporter::cached_name exporter::_register_name(
+		name_allocator &alloc, const clang::Decl *decl, std::string_view role, naming_convention::name_info name,
+		std::string_view prefix
+	) {
+		std::string key;
+		if (ledger) {
+			key = name_ledger::get_key(decl, role);
+		}
+		cached_name result;
+		if (auto it = _reserved_names.find(key); !key.empty() && it != _reserved_names.end()) {
+			result = cached_name(std::move(it->second));
+			_reserved_names.erase(it);
+		} else if (prefix.empty()) {
+			result = cached_name::register_name(alloc, std::move(name));
+		} else {
+			result = cached_name::register_name_prefix(alloc, prefix, std::move(name));
+		}
+		if (!key.empty()) {
+			_ledger_names.emplace_back(std::move(key), result.get_info());
+		}
+		return result;
+	}
+
+	void exporter::_freeze(cached_name &name) {
+		name.freeze();
+		const name_allocator::name_info *info = name.get_info();
+		if (info && info->shorten) {
+			if (std::string full = info->get_full_name(); full != name.get_cached()) {
+				_shortened_names.try_emplace(std::string(name.get_cached()), std::move(full));
+			}
+		}
+	}
+
+	void exporter::_register_vector_type(const clang::Type *type, const clang::ASTContext &context) {
+		auto *vector = llvm::dyn_cast<clang::VectorType>(type);
+		if (!vector || _vector_type_names.find(vector) != _vector_type_names.end()) {
+			return;
+		}
+		auto *element = llvm::dyn_cast<clang::BuiltinType>(vector->getElementType().getCanonicalType().getTypePtr());
+		if (!element) {
+			return;
+		}
+		std::string element_name(to_string_view(element->getName(printing_policy)));
+		std::replace(element_name.begin(), element_name.end(), ' ', '_');
+		vector_type_naming name;
+		name.name = cached_name(_global_scope.allocate_variable_custom(
+			fmt::format(naming->vector_type_name_pattern, element_name, vector->getNumElements()), "_vector"
+		));
+		_freeze(name.name);
+		name.size = static_cast<std::uint64_t>(context.getTypeSizeInChars(vector).getQuantity());
+		_vector_type_names.emplace(vector, std::move(name));
+	}
+
+	bool exporter::_is_typed_array(const qualified_type &type) {
+		// pointers to incomplete types cannot be expressed as arrays, and arrays of pointers are kept as-is
+		if (!type.is_array() || type.is_reference() || type.qualifiers.size() != type.array_extents.size() + 1) {
+			return false;
+		}
+		if (auto *vector = llvm::dyn_cast<clang::VectorType>(type.type)) {
+			return llvm::isa<clang::BuiltinType>(vector->getElementType().getCanonicalType().getTypePtr());
+		}
+		return (llvm::isa<clang::BuiltinType>(type.type) && !type.type->isVoidType()) || type.type->isEnumeralType();
+	}
+
+	std::string exporter::_get_array_type_key(const qualified_type &type) const {
+		std::string result(get_exported_type_name(type.type, type.type_entity));
+		for (std::uint64_t extent : type.array_extents) {
+			result += fmt::format("[{}]", extent);
+		}
+		return result;
+	}
+
+	void exporter::_register_array_type(const qualified_type &type) {
+		std::string key = _get_array_type_key(type);
+		if (_array_type_names.find(key) != _array_type_names.end()) {
+			return;
+		}
+		array_type_naming name;
+		name.element = std::string(get_exported_type_name(type.type, type.type_entity));
+		name.extents = type.array_extents;
+		std::string element_name = name.element;
+		std::replace(element_name.begin(), element_name.end(), ' ', '_');
+		std::string extents;
+		for (std::uint64_t extent : type.array_extents) {
+			if (!extents.empty()) {
+				extents += 'x';
+			}
+			extents += std::to_string(extent);
+		}
+		name.name = cached_name(_global_scope.allocate_variable_custom(
+			fmt::format(naming->array_type_name_pattern, element_name, extents), "_array"
+		));
+		_freeze(name.name);
+		_array_type_names.emplace(std::move(key), std::move(name));
+	}
+
+	std::string exporter::_get_batch_rejection_reason(entities::function_entity *entity) const {
+		if (isa<entities::constructor_entity>(*entity)) {
+			return "it is a constructor";
+		}
+		if (entity->get_declaration()->isVariadic()) {
+			return "it is variadic";
+		}
+		auto is_supported = [this](const qualified_type &type) {
+			return !type.is_record_type() || is_passed_by_value(type);
+		};
+		if (auto &return_type = entity->get_api_return_type(); return_type && !is_supported(return_type.value())) {
+			return "it returns a record through a pointer";
+		}
+		auto &params = entity->get_parameters();
+		for (std::size_t i = 0; i < params.size(); ++i) {
+			if (!is_supported(params[i].type)) {
+				return fmt::format(
+					"its parameter {} ({}) is a record passed through a pointer",
+					i, params[i].name.empty() ? "unnamed" : params[i].name
+				);
+			}
+		}
+		return "";
+	}
+
+	void exporter::_register_batch_function(entities::function_entity *entity, function_naming &name) {
+		if (!entity->is_batched()) {
+			return;
+		}
+		if (std::string reason = _get_batch_rejection_reason(entity); !reason.empty()) {
+			logger::get().log(
+				log_category::naming, log_level::warning, "batch variant of {} is not exported since {}",
+				entity->get_declaration()->getQualifiedNameAsString(), reason
+			);
+			return;
+		}
+		auto *decl = entity->get_declaration();
+		auto batch_name = naming->get_function_batch_name(*entity);
+		name.batch_impl_name = _register_name(_impl_scope, decl, _role_batch_impl, batch_name, "internal_");
+		name.batch_api_name = _register_name(_global_scope, decl, _role_batch, std::move(batch_name));
+		name.batch = true;
+	}
+
+	qualified_type exporter::_get_batch_array_type(const qualified_type &type, bool input) {
+		qualified_type result = type;
+		if (result.is_reference()) { // references are stored as pointers
+			result.ref_kind = reference_kind::none;
+			result.qualifiers.insert(result.qualifiers.begin(), qualifier::none);
+		}
+		result.qualifiers.front() = input ? qualifier::const_qual : qualifier::none;
+		result.qualifiers.insert(result.qualifiers.begin(), qualifier::none);
+		return result;
+	}
+
+	bool exporter::_is_view_field(const entities::field_entity *field) const {
+		const qualified_type &type = field->get_type();
+		if (
+			field->get_field_kind() == entities::field_kind::reference_field || type.is_reference() ||
+			type.is_array() || field->get_declaration()->getName().empty()
+		) {
+			return false;
+		}
+		if (type.qualifiers.size() == 1) { // scalars
+			if (auto *vector = llvm::dyn_cast<clang::VectorType>(type.type)) {
+				return llvm::isa<clang::BuiltinType>(vector->getElementType().getCanonicalType().getTypePtr());
+			}
+			return
+				(llvm::isa<clang::BuiltinType>(type.type) && !type.type->isVoidType()) ||
+				(type.type->isEnumeralType() && _enum_names.find(
+					dyn_cast<entities::enum_entity>(type.type_entity)
+				) != _enum_names.end());
+		}
+		// pointers; function pointers are not supported
+		if (llvm::isa<clang::BuiltinType>(type.type)) {
+			return true;
+		}
+		if (type.type->isEnumeralType()) {
+			return _enum_names.find(dyn_cast<entities::enum_entity>(type.type_entity)) != _enum_names.end();
+		}
+		if (type.type->isRecordType()) {
+			return _record_names.find(dyn_cast<entities::record_entity>(type.type_entity)) != _record_names.end();
+		}
+		return false;
+	}
+
+	void exporter::_register_record_view(
+		entities::record_entity *ent, record_naming &name, name_allocator &api_table_scope
+	) {
+		if (name.view_fields.empty()) {
+			return;
+		}
+		if (name.view_fields.size() > _max_view_fields) {
+			logger::get().log(
+				log_category::naming, log_level::warning,
+				"only the first {} of the {} eligible fields of {} are included in its view",
+				_max_view_fields, name.view_fields.size(), ent->get_declaration()->getQualifiedNameAsString()
+			);
+			name.view_fields.resize(_max_view_fields);
+		}
+		auto *decl = ent->get_declaration();
+		auto snapshot_name = naming->get_record_snapshot_name(*ent);
+		name.snapshot_impl_name = _register_name(_impl_scope, decl, _role_snapshot_impl, snapshot_name, "internal_");
+		name.snapshot_api_name = _register_name(api_table_scope, decl, _role_snapshot, std::move(snapshot_name));
+		if (name.has_apply_function()) {
+			auto apply_name = naming->get_record_apply_name(*ent);
+			name.apply_impl_name = _register_name(_impl_scope, decl, _role_apply_impl, apply_name, "internal_");
+			name.apply_api_name = _register_name(api_table_scope, decl, _role_apply, std::move(apply_name));
+		}
+	}
+
+
+	// parallel exporting
+	/// Calls the given function for indices in <cc>[0, count)</cc> on the calling thread and on additional worker
+	/// threads. Workers are counted in \p busy_workers, which is shared by all concurrent calls, so that at most
+	/// <cc>num_threads - 1</cc> workers run at the same time no matter how many threads call this function.
+	template <typename Func> void _parallel_for(
+		std::size_t count, std::size_t num_threads, std::atomic<std::size_t> &busy_workers, const Func &func
+	) {
+		std::size_t workers = 0;
+		if (count > 1 && num_threads > 1) {
+			std::size_t max_workers = num_threads - 1, busy = busy_workers.load();
+			do {
+				workers = std::min(count - 1, busy < max_workers ? max_workers - busy : 0);
+			} while (workers > 0 && !busy_workers.compare_exchange_weak(busy, busy + workers));
+		}
+		if (workers == 0) {
+			for (std::size_t i = 0; i < count; ++i) {
+				func(i);
+			}
+			return;
+		}
+		std::atomic<std::size_t> next = 0;
+		auto worker = [&]() {
+			for (std::size_t i = next++; i < count; i = next++) {
+				func(i);
+			}
+		};
+		std::vector<std::thread> threads;
+		threads.reserve(workers);
+		for (std::size_t i = 0; i < workers; ++i) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+		busy_workers -= workers;
+	}
+
+	template <typename Mapping, typename Func, typename Pred> void exporter::_export_fragments(
+		cpp_writer &writer, const Mapping &names, const Func &func, const Pred &pred
+	) const {
+		if (num_threads < 2) {
+			for (auto &&[ent, name] : names) {
+				if (pred(ent, name)) {
+					writer.new_line();
+					func(writer, ent, name);
+					writer.new_line();
+				}
+			}
+			return;
+		}
+
+		std::vector<const typename Mapping::value_type*> elements;
+		for (auto &element : names) {
+			if (pred(element.first, element.second)) {
+				elements.emplace_back(&element);
+			}
+		}
+		if (elements.empty()) {
+			return;
+		}
+		writer.new_line(); // so that the indentation of the first line of each fragment is known
+		std::size_t indent = writer.get_indent();
+		std::vector<std::string> fragments(elements.size());
+		_parallel_for(elements.size(), num_threads, _busy_workers, [&](std::size_t i) {
+			auto &&[ent, name] = *elements[i];
+			cpp_writer fragment_writer(printing_policy, indent);
+			func(fragment_writer, ent, name);
+			fragments[i] = std::string(fragment_writer.get_buffered_contents());
+		});
+		for (std::size_t i = 0; i < fragments.size(); ++i) {
+			if (i > 0) {
+				writer.new_line();
+			}
+			writer
+				.write(fragments[i])
+				.new_line();
+		}
+	}
+
+
 	// exporting of api types
 	std::string_view exporter::get_exported_type_name(const clang::Type *type, entity *entity) const {
 		if (auto *builtin = llvm::dyn_cast<clang::BuiltinType>(type)) {
@@ -13,15 +448,27 @@ namespace apigen {
 			return _enum_names.at(cast<entities::enum_entity>(entity)).name.get_cached();
 		} else if (llvm::isa<clang::RecordType>(type)) {
 			return _record_names.at(cast<entities::record_entity>(entity)).name.get_cached();
+		} else if (auto *vector = llvm::dyn_cast<clang::VectorType>(type)) {
+			if (auto it = _vector_type_names.find(vector); it != _vector_type_names.end()) {
+				return it->second.name.get_cached();
+			}
 		}
 		return "$UNSUPPORTED";
 	}
 
+	bool exporter::is_passed_by_value(const qualified_type &type) const {
+		if (!type.is_record_type()) {
+			return false;
+		}
+		auto it = _record_names.find(dyn_cast<entities::record_entity>(type.type_entity));
+		return it != _record_names.end() && !it->second.value_fields.empty();
+	}
+
 	void exporter::export_api_parameter_type(cpp_writer &writer, const qualified_type &type, bool mark_move) const {
 		writer.write_fmt("{} ", get_exported_type_name(type.type, type.type_entity));
 		if (type.is_reference_or_pointer()) {
 			export_api_pointers_and_qualifiers(writer, type.ref_kind, type.qualifiers);
-		} else {
+		} else if (!is_passed_by_value(type)) {
 			if (auto *complex_ty = dyn_cast<entities::record_entity>(type.type_entity)) {
 				if (!complex_ty->has_move_constructor()) {
 					writer.write("const "); // this parameter will be copied
@@ -40,7 +487,7 @@ namespace apigen {
 		if (type.is_reference_or_pointer()) {
 			export_api_pointers_and_qualifiers(writer, type.ref_kind, type.qualifiers);
 		} else {
-			if (type.type_entity && isa<entities::record_entity>(*type.type_entity)) {
+			if (type.type_entity && isa<entities::record_entity>(*type.type_entity) && !is_passed_by_value(type)) {
 				writer.write('*');
 			}
 		}
@@ -77,6 +524,12 @@ namespace apigen {
 	void exporter::_export_api_enum_type(
 		cpp_writer &writer, entities::enum_entity *entity, const enum_naming &name
 	) const {
+		_export_api_enumerators(writer, name);
+		writer.new_line();
+		_export_api_enum_typedef(writer, entity, name);
+	}
+
+	void exporter::_export_api_enumerators(cpp_writer &writer, const enum_naming &name) {
 		writer.write("enum ");
 		{
 			auto scope = writer.begin_scope(cpp_writer::braces_scope);
@@ -87,18 +540,129 @@ namespace apigen {
 					.maybe_separate(",");
 			}
 		}
+		writer.write(";");
+	}
+
+	void exporter::_export_api_enum_typedef(
+		cpp_writer &writer, entities::enum_entity *entity, const enum_naming &name
+	) const {
+		writer.write_fmt(
+			"typedef {} {};",
+			get_exported_type_name(entity->get_integer_type(), nullptr),
+			name.name.get_cached()
+		);
+	}
+
+	void exporter::_export_api_vector_type(
+		cpp_writer &writer, const clang::VectorType *type, const vector_type_naming &name
+	) {
+		std::string element = type->getElementType().getCanonicalType().getAsString(writer.name_printer.policy);
+		if (!llvm::isa<clang::ExtVectorType>(type)) {
+			writer.write_fmt(
+				"typedef {} {} __attribute__((vector_size({})));", element, name.name.get_cached(), name.size
+			);
+			return;
+		}
+		// ext_vector_type is clang-specific; other compilers get a vector of the same size and alignment
 		writer
-			.write(";")
+			.write("#ifdef __clang__")
 			.new_line()
 			.write_fmt(
-				"typedef {} {};",
-				get_exported_type_name(entity->get_integer_type(), nullptr),
-				name.name.get_cached()
-			);
+				"typedef {} {} __attribute__((ext_vector_type({})));",
+				element, name.name.get_cached(), type->getNumElements()
+			)
+			.new_line()
+			.write("#else")
+			.new_line()
+			.write_fmt("typedef {} {} __attribute__((vector_size({})));", element, name.name.get_cached(), name.size)
+			.new_line()
+			.write("#endif");
+	}
+
+	void exporter::_export_api_array_type(cpp_writer &writer, const array_type_naming &name) {
+		writer.write_fmt("typedef {} {}", name.element, name.name.get_cached());
+		for (std::uint64_t extent : name.extents) {
+			writer.write_fmt("[{}]", extent);
+		}
+		writer.write(";");
 	}
 
 	void exporter::_export_api_type(cpp_writer &writer, const record_naming &name) {
-		writer.write_fmt("typedef struct {0} {0};", name.name.get_cached());
+		_export_api_record_declaration(writer, name);
+		if (name.size != 0) {
+			writer.new_line();
+			_export_api_record_layout(writer, name);
+		}
+	}
+
+	void exporter::_export_api_record_declaration(cpp_writer &writer, const record_naming &name) {
+		if (name.value_fields.empty()) {
+			writer.write_fmt("typedef struct {0} {0};", name.name.get_cached());
+		} else { // mirror the layout of the record
+			writer.write_fmt("typedef struct {} ", name.name.get_cached());
+			{
+				auto scope = writer.begin_scope(cpp_writer::braces_scope);
+				for (const std::string &field : name.value_fields) {
+					writer
+						.new_line()
+						.write_fmt("{};", field);
+				}
+			}
+			writer.write_fmt(" {};", name.name.get_cached());
+		}
+	}
+
+	void exporter::_export_api_record_layout(cpp_writer &writer, const record_naming &name) {
+		writer
+			.write_fmt(
+				"enum {{ {} = {}, {} = {} }};",
+				name.size_name.get_cached(), name.size, name.align_name.get_cached(), name.alignment
+			)
+			.new_line()
+			.write_fmt(
+				"typedef struct {0} {{ APIGEN_ALIGNAS({1}) unsigned char data[{2}]; }} {0};",
+				name.storage_name.get_cached(), name.align_name.get_cached(), name.size_name.get_cached()
+			);
+	}
+
+	void exporter::_export_api_view_field_type(cpp_writer &writer, const entities::field_entity *field) const {
+		// views are filled by assignment, so top-level qualifiers are dropped
+		qualified_type type = field->get_type();
+		type.qualifiers.front() = qualifier::none;
+		export_api_return_type(writer, type);
+	}
+
+	void exporter::_export_api_record_view(cpp_writer &writer, const record_naming &name) const {
+		writer.write_fmt("typedef struct {} ", name.view_name.get_cached());
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			for (entities::field_entity *field : name.view_fields) {
+				writer.new_line();
+				_export_api_view_field_type(writer, field);
+				writer.write_fmt("{};", to_string_view(field->get_declaration()->getName()));
+			}
+		}
+		writer.write_fmt(" {};", name.view_name.get_cached());
+		if (!name.has_apply_function()) {
+			return;
+		}
+		// bit indices instead of masks, since enumerators cannot hold all 64 bits in C
+		writer
+			.new_line()
+			.write("enum ");
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			for (std::size_t i = 0; i < name.view_fields.size(); ++i) {
+				if (!_is_view_field_writable(name.view_fields[i])) {
+					continue; // const fields are never written back, so their bits are left unnamed
+				}
+				writer
+					.new_line()
+					.write_fmt("{} = {}", name.view_bit_names[i].get_cached(), i)
+					.maybe_separate(",");
+			}
+		}
+		writer.write(";");
 	}
 
 	void exporter::_export_api_function_pointer_definition(
@@ -124,42 +688,293 @@ namespace apigen {
 		writer.write(";");
 	}
 
+	void exporter::_export_api_batch_function_pointer_definition(
+		cpp_writer &writer, entities::function_entity *entity, const function_naming &name
+	) const {
+		writer.write_fmt("void (*{})", name.batch_api_name.get_cached());
+		{
+			auto scope = writer.begin_scope(cpp_writer::parentheses_scope);
+			for (auto &&param : entity->get_parameters()) {
+				writer.new_line();
+				export_api_parameter_type(writer, _get_batch_array_type(param.type, true), false);
+				writer.maybe_separate(",");
+			}
+			if (auto &return_type = entity->get_api_return_type(); return_type && !return_type->is_void()) {
+				writer.new_line();
+				export_api_return_type(writer, _get_batch_array_type(return_type.value(), false));
+				writer.maybe_separate(",");
+			}
+			writer
+				.new_line()
+				.write("unsigned long long");
+		}
+		writer.write(";");
+	}
+
 	void exporter::_export_api_destructor_definition(
 		cpp_writer &writer, entities::record_entity*, const record_naming &name
 	) const {
 		writer.write_fmt("void (*{})({} *);", name.destructor_api_name.get_cached(), name.name.get_cached());
 	}
 
+	void exporter::_export_api_record_view_function_definition(
+		cpp_writer &writer, const record_naming &name, bool apply
+	) const {
+		if (apply) {
+			writer.write_fmt(
+				"void (*{})({} *, {} const *, unsigned long long);",
+				name.apply_api_name.get_cached(), name.name.get_cached(), name.view_name.get_cached()
+			);
+		} else {
+			writer.write_fmt(
+				"void (*{})({} const *, {} *);",
+				name.snapshot_api_name.get_cached(), name.name.get_cached(), name.view_name.get_cached()
+			);
+		}
+	}
+
 	void exporter::_export_api_field_getter_definitions(
 		cpp_writer &writer, entities::field_entity *entity, const field_naming &name
 	) const {
-		auto &type = entity->get_type();
-		auto parent_it = _record_names.find(entity->get_parent());
-		assert_true(parent_it != _record_names.end());
-
 		// only normal fields have non-const getters
 		if (entity->get_field_kind() == entities::field_kind::normal_field) {
+			_export_api_field_getter_definition(writer, entity, name, false);
+			writer.new_line();
+		}
+		_export_api_field_getter_definition(writer, entity, name, true);
+		if (_is_typed_array(entity->get_type())) {
+			writer.new_line();
+			_export_api_field_copy_definition(writer, entity, name, false);
+			if (entity->get_field_kind() == entities::field_kind::normal_field) {
+				writer.new_line();
+				_export_api_field_copy_definition(writer, entity, name, true);
+			}
+		}
+	}
+
+	void exporter::_export_api_field_getter_return_type(
+		cpp_writer &writer, entities::field_entity *entity, bool is_const
+	) const {
+		auto &type = entity->get_type();
+		if (!_is_typed_array(type)) {
 			writer.write_fmt("{} ", get_exported_type_name(type.type, type.type_entity));
 			_export_api_field_getter_return_type_pointers_and_qualifiers(
-				writer, type, entity->get_field_kind(), false
+				writer, type, entity->get_field_kind(), is_const
 			);
-			writer
-				.write_fmt("(*{})({} *);", name.getter_api_name.get_cached(), parent_it->second.name.get_cached())
-				.new_line();
+			return;
 		}
-
-		writer.write_fmt("{} ", get_exported_type_name(type.type, type.type_entity));
-		_export_api_field_getter_return_type_pointers_and_qualifiers(
-			writer, type, entity->get_field_kind(), true
-		);
-		writer.write_fmt(
-			"(*{})({} const *);", name.const_getter_api_name.get_cached(), parent_it->second.name.get_cached()
-		);
+		// qualifiers of an array typedef apply to its elements
+		writer
+			.write_fmt("{} ", _array_type_names.at(_get_array_type_key(type)).name.get_cached())
+			.write(type.get_element_qualifiers());
+		if (entity->get_field_kind() == entities::field_kind::normal_field && is_const) {
+			writer.write("const ");
+		}
+		writer.write("*");
 	}
 
+	void exporter::_export_api_inline_field_accessors(
+		cpp_writer &writer, entities::field_entity *entity, const field_naming &name
+	) const {
+		auto parent_it = _record_names.find(entity->get_parent());
+		assert_true(parent_it != _record_names.end());
+		auto export_accessor = [&](const cached_name &func_name, bool is_const) {
+			name_allocator alloc = name_allocator::from_parent_immutable(_global_scope);
+			auto input = alloc.allocate_function_parameter("object", "");
+			std::string_view qualifier = is_const ? "const " : "";
+			writer.write("APIGEN_INLINE ");
+			_export_api_field_getter_return_type(writer, entity, is_const);
+			writer.write_fmt(
+				"{}({} {}*{}) ",
+				func_name.get_cached(), parent_it->second.name.get_cached(), qualifier, input->get_name()
+			);
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			writer
+				.new_line()
+				.write("return (");
+			_export_api_field_getter_return_type(writer, entity, is_const);
+			writer.write_fmt(")((char {}*){} + {});", qualifier, input->get_name(), name.offset.value());
+		};
+		if (entity->get_field_kind() == entities::field_kind::normal_field) {
+			export_accessor(name.inline_getter_name, false);
+			writer.new_line();
+		}
+		export_accessor(name.inline_const_getter_name, true);
+	}
 
-	void exporter::_export_pass_parameter(
-		cpp_writer &writer, const qualified_type &type, std::string_view param
+	void exporter::_export_api_field_copy_definition(
+		cpp_writer &writer, entities::field_entity *entity, const field_naming &name, bool copy_in
+	) const {
+		auto parent_it = _record_names.find(entity->get_parent());
+		assert_true(parent_it != _record_names.end());
+		std::string_view array_name = _array_type_names.at(_get_array_type_key(entity->get_type())).name.get_cached();
+		if (copy_in) {
+			writer.write_fmt(
+				"void (*{})({} *, {} const *);",
+				name.copy_in_api_name.get_cached(), parent_it->second.name.get_cached(), array_name
+			);
+		} else {
+			writer.write_fmt(
+				"void (*{})({} const *, {} *);",
+				name.copy_out_api_name.get_cached(), parent_it->second.name.get_cached(), array_name
+			);
+		}
+	}
+
+	void exporter::_export_api_field_getter_definition(
+		cpp_writer &writer, entities::field_entity *entity, const field_naming &name, bool is_const
+	) const {
+		auto parent_it = _record_names.find(entity->get_parent());
+		assert_true(parent_it != _record_names.end());
+
+		_export_api_field_getter_return_type(writer, entity, is_const);
+		if (is_const) {
+			writer.write_fmt(
+				"(*{})({} const *);", name.const_getter_api_name.get_cached(), parent_it->second.name.get_cached()
+			);
+		} else {
+			writer.write_fmt("(*{})({} *);", name.getter_api_name.get_cached(), parent_it->second.name.get_cached());
+		}
+	}
+
+	std::vector<std::string_view> exporter::_get_api_table_slot_names(std::string_view group) const {
+		std::vector<std::string_view> result;
+		for (auto &&[ent, name] : _function_names) {
+			if (_get_api_group(ent) == group) {
+				result.emplace_back(name.api_name.get_cached());
+				if (name.batch) {
+					result.emplace_back(name.batch_api_name.get_cached());
+				}
+			}
+		}
+		for (auto &&[ent, name] : _record_names) {
+			if (_get_api_group(ent) == group) {
+				result.emplace_back(name.destructor_api_name.get_cached());
+				if (!name.view_fields.empty()) {
+					result.emplace_back(name.snapshot_api_name.get_cached());
+					if (name.has_apply_function()) {
+						result.emplace_back(name.apply_api_name.get_cached());
+					}
+				}
+			}
+		}
+		for (auto &&[ent, name] : _field_names) {
+			if (_get_api_group(ent) == group) {
+				if (ent->get_field_kind() == entities::field_kind::normal_field) {
+					result.emplace_back(name.getter_api_name.get_cached());
+				}
+				result.emplace_back(name.const_getter_api_name.get_cached());
+				if (_is_typed_array(ent->get_type())) {
+					result.emplace_back(name.copy_out_api_name.get_cached());
+					if (ent->get_field_kind() == entities::field_kind::normal_field) {
+						result.emplace_back(name.copy_in_api_name.get_cached());
+					}
+				}
+			}
+		}
+		for (auto &&[ent, name] : _custom_func_names) {
+			if (_get_api_group(ent) == group) {
+				result.emplace_back(name.api_name.get_cached());
+			}
+		}
+		return result;
+	}
+
+	void exporter::_export_stable_api_table_members(cpp_writer &writer) const {
+		assert_true(_api_groups.empty(), "stable layouts cannot be used with sub-tables");
+
+		using _member_exporter = std::function<void(cpp_writer&)>;
+		// exporters of all members, indexed by their names
+		std::unordered_map<std::string_view, _member_exporter> exporters;
+		for (auto &&[ent, name] : _function_names) {
+			exporters.emplace(name.api_name.get_cached(), [this, func = ent, names = &name](cpp_writer &w) {
+				_export_api_function_pointer_definition(w, func, *names);
+			});
+			if (name.batch) {
+				exporters.emplace(name.batch_api_name.get_cached(), [this, func = ent, names = &name](cpp_writer &w) {
+					_export_api_batch_function_pointer_definition(w, func, *names);
+				});
+			}
+		}
+		for (auto &&[ent, name] : _record_names) {
+			exporters.emplace(name.destructor_api_name.get_cached(), [this, rec = ent, names = &name](cpp_writer &w) {
+				_export_api_destructor_definition(w, rec, *names);
+			});
+			if (!name.view_fields.empty()) {
+				exporters.emplace(name.snapshot_api_name.get_cached(), [this, names = &name](cpp_writer &w) {
+					_export_api_record_view_function_definition(w, *names, false);
+				});
+				if (name.has_apply_function()) {
+					exporters.emplace(name.apply_api_name.get_cached(), [this, names = &name](cpp_writer &w) {
+						_export_api_record_view_function_definition(w, *names, true);
+					});
+				}
+			}
+		}
+		for (auto &&[ent, name] : _field_names) {
+			if (ent->get_field_kind() == entities::field_kind::normal_field) {
+				exporters.emplace(
+					name.getter_api_name.get_cached(), [this, field = ent, names = &name](cpp_writer &w) {
+						_export_api_field_getter_definition(w, field, *names, false);
+					}
+				);
+			}
+			exporters.emplace(
+				name.const_getter_api_name.get_cached(), [this, field = ent, names = &name](cpp_writer &w) {
+					_export_api_field_getter_definition(w, field, *names, true);
+				}
+			);
+			if (_is_typed_array(ent->get_type())) {
+				exporters.emplace(
+					name.copy_out_api_name.get_cached(), [this, field = ent, names = &name](cpp_writer &w) {
+						_export_api_field_copy_definition(w, field, *names, false);
+					}
+				);
+				if (ent->get_field_kind() == entities::field_kind::normal_field) {
+					exporters.emplace(
+						name.copy_in_api_name.get_cached(), [this, field = ent, names = &name](cpp_writer &w) {
+							_export_api_field_copy_definition(w, field, *names, true);
+						}
+					);
+				}
+			}
+		}
+		for (auto &&[ent, name] : _custom_func_names) {
+			exporters.emplace(name.api_name.get_cached(), [this, func = ent, names = &name](cpp_writer &w) {
+				func->export_pointer_declaration(w, *this, names->api_name.get_cached());
+			});
+		}
+
+		std::vector<std::pair<std::size_t, _member_exporter>> members;
+		const std::vector<slot_ledger::slot> &slots = slot_layout->get_slots();
+		for (std::size_t i = 0; i < slots.size(); ++i) {
+			if (slots[i].tombstone) {
+				members.emplace_back(i, [i](cpp_writer &w) {
+					w.write_fmt("void (*{})(void);", get_tombstone_name(i));
+				});
+			} else {
+				auto it = exporters.find(slots[i].name);
+				assert_true(it != exporters.end(), "slot ledger is out of date");
+				members.emplace_back(i, std::move(it->second));
+			}
+		}
+
+		writer
+			.new_line()
+			.write_fmt("unsigned int {};", api_size_member_name)
+			.new_line()
+			.write_fmt("unsigned int {};", api_version_member_name)
+			.new_line();
+		_export_fragments(writer, members, [](cpp_writer &w, std::size_t, const _member_exporter &func) {
+			func(w);
+		}, [](std::size_t, const _member_exporter&) {
+			return true;
+		});
+	}
+
+
+	void exporter::_export_pass_parameter(
+		cpp_writer &writer, const qualified_type &type, std::string_view param
 	) const {
 		if (type.is_reference_or_pointer()) { // passing a reference
 			cpp_writer::scope_token scope;
@@ -189,20 +1004,27 @@ namespace apigen {
 			}
 		} else { // passing an object
 			if (auto *complex_ty = dyn_cast<entities::record_entity>(type.type_entity)) {
-				cpp_writer::scope_token possible_move;
-				std::string cast_type;
-				if (complex_ty->has_move_constructor()) { // move
-					writer.write("::std::move");
-					possible_move = writer.begin_scope(cpp_writer::parentheses_scope);
-					cast_type = writer.name_printer.get_internal_qualified_type_name(
-						type.type, reference_kind::none, { qualifier::none, qualifier::none }
+				if (is_passed_by_value(type)) { // the API struct has the same layout, copy it as the internal type
+					writer.write_fmt(
+						"{}<{}>({})",
+						_value_conversion_name, writer.name_printer.get_internal_type_name(type.type), param
 					);
 				} else {
-					cast_type = writer.name_printer.get_internal_qualified_type_name(
-						type.type, reference_kind::none, { qualifier::none, qualifier::const_qual }
-					);
+					cpp_writer::scope_token possible_move;
+					std::string cast_type;
+					if (complex_ty->has_move_constructor()) { // move
+						writer.write("::std::move");
+						possible_move = writer.begin_scope(cpp_writer::parentheses_scope);
+						cast_type = writer.name_printer.get_internal_qualified_type_name(
+							type.type, reference_kind::none, { qualifier::none, qualifier::none }
+						);
+					} else {
+						cast_type = writer.name_printer.get_internal_qualified_type_name(
+							type.type, reference_kind::none, { qualifier::none, qualifier::const_qual }
+						);
+					}
+					writer.write_fmt("*reinterpret_cast<{}>({})", cast_type, param);
 				}
-				writer.write_fmt("*reinterpret_cast<{}>({})", cast_type, param);
 			} else { // primitive types
 				if (type.type->isEnumeralType()) { // cast enums
 					writer.write_fmt(
@@ -261,9 +1083,74 @@ namespace apigen {
 		}
 	}
 
+	bool exporter::_can_elide_wrapper(entities::function_entity *entity) {
+		if (auto *method_ent = dyn_cast<entities::method_entity>(entity)) {
+			if (isa<entities::constructor_entity>(*method_ent) || !method_ent->is_static()) {
+				return false;
+			}
+		}
+		clang::FunctionDecl *decl = entity->get_declaration();
+		if (decl->isVariadic()) {
+			return false;
+		}
+		// the function pointer in the API structure always has the default calling convention
+		auto *func_type = decl->getType()->getAs<clang::FunctionType>();
+		if (!func_type || func_type->getCallConv() != clang::CC_C) {
+			return false;
+		}
+		// enums, references, and records all need conversions
+		auto is_compatible = [](const qualified_type &type) {
+			return
+				type.ref_kind == reference_kind::none &&
+				(llvm::isa<clang::BuiltinType>(type.type) || llvm::isa<clang::VectorType>(type.type));
+		};
+		auto &return_type = entity->get_api_return_type();
+		if (!return_type || !is_compatible(return_type.value())) {
+			return false;
+		}
+		for (auto &&param : entity->get_parameters()) {
+			if (!is_compatible(param.type)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	void exporter::_export_function_impl(
 		cpp_writer &writer, entities::function_entity *entity, const function_naming &name
 	) const {
+		if (elide_wrappers && _can_elide_wrapper(entity)) {
+			logger::get().log(
+				log_category::exporting, log_level::debug, "eliding wrapper of {}", name.api_name.get_cached()
+			);
+			// a constant pointer is used instead of the function itself so that the access check happens in this
+			// class, and so that calls from direct-link functions can still be inlined
+			writer.write("inline static constexpr ");
+			export_api_return_type(writer, entity->get_api_return_type().value());
+			writer.write_fmt("(*{})", name.impl_name.get_cached());
+			{
+				auto scope = writer.begin_scope(cpp_writer::parentheses_scope);
+				for (auto &&param : entity->get_parameters()) {
+					writer.new_line();
+					export_api_parameter_type(writer, param.type, false);
+					writer.maybe_separate(",");
+				}
+			}
+			writer.write(" = &");
+			if (auto *method_ent = dyn_cast<entities::method_entity>(entity)) {
+				auto *method_decl = llvm::cast<clang::CXXMethodDecl>(method_ent->get_declaration());
+				writer.write_fmt(
+					"{}::{}",
+					writer.name_printer.get_internal_entity_name(method_decl->getParent()),
+					writer.name_printer.get_internal_function_name(method_decl)
+				);
+			} else {
+				writer.write(writer.name_printer.get_internal_entity_name(entity->get_declaration()));
+			}
+			writer.write(";");
+			return;
+		}
+
 		name_allocator alloc = name_allocator::from_parent_immutable(_impl_scope);
 		std::vector<name_allocator::token> param_tokens;
 		std::vector<std::string> parameters;
@@ -274,6 +1161,7 @@ namespace apigen {
 		}
 		writer.write_fmt("{}", name.impl_name.get_cached());
 		bool complex_return = false; // indicates whether the function call should be wrapped in a placement new
+		bool value_return = false; // indicates whether the returned object should be converted to its API struct
 		{
 			auto scope = writer.begin_scope(cpp_writer::parentheses_scope);
 			for (auto &&param : entity->get_parameters()) {
@@ -286,7 +1174,9 @@ namespace apigen {
 					.maybe_separate(",");
 			}
 			if (auto &return_type = entity->get_api_return_type()) {
-				if (return_type->is_record_type()) {
+				if (is_passed_by_value(return_type.value())) {
+					value_return = true;
+				} else if (return_type->is_record_type()) {
 					// additional input pointing to the memory block that receives the returned object
 					param_tokens.emplace_back(alloc.allocate_function_parameter("output", ""));
 					parameters.emplace_back(param_tokens.back()->get_name());
@@ -313,6 +1203,22 @@ namespace apigen {
 					auto new_scope = writer.begin_scope(cpp_writer::parentheses_scope);
 					_export_plain_function_call(writer, entity, parameters);
 				}
+			} else if (value_return) {
+				// store the object in a local variable and copy it into the API struct
+				auto result_token = alloc.allocate_local_variable("result", "");
+				writer.write_fmt("auto {} = ", result_token->get_name());
+				_export_plain_function_call(writer, entity, parameters);
+				writer
+					.write(";")
+					.new_line()
+					.write_fmt(
+						"return {}<{}>({})",
+						_value_conversion_name,
+						_record_names.at(cast<entities::record_entity>(
+							entity->get_api_return_type().value().type_entity
+						)).name.get_cached(),
+						result_token->get_name()
+					);
 			} else { // simple or no return
 				auto &return_type = entity->get_api_return_type();
 				if (return_type && !return_type->is_void()) { // simple return
@@ -359,21 +1265,76 @@ namespace apigen {
 		}
 	}
 
+	void exporter::_export_batch_function_impl(
+		cpp_writer &writer, entities::function_entity *entity, const function_naming &name
+	) const {
+		name_allocator alloc = name_allocator::from_parent_immutable(_impl_scope);
+		std::vector<name_allocator::token> param_tokens;
+		name_allocator::token results, count;
+		auto &return_type = entity->get_api_return_type();
+		bool has_results = return_type && !return_type->is_void();
+
+		writer.write_fmt("inline static void {}", name.batch_impl_name.get_cached());
+		{
+			auto scope = writer.begin_scope(cpp_writer::parentheses_scope);
+			for (auto &&param : entity->get_parameters()) {
+				writer.new_line();
+				export_api_parameter_type(writer, _get_batch_array_type(param.type, true), false);
+				param_tokens.emplace_back(alloc.allocate_function_parameter(param.name, ""));
+				writer
+					.write(param_tokens.back()->get_name())
+					.maybe_separate(",");
+			}
+			if (has_results) {
+				writer.new_line();
+				export_api_return_type(writer, _get_batch_array_type(return_type.value(), false));
+				results = alloc.allocate_function_parameter("results", "");
+				writer
+					.write(results->get_name())
+					.maybe_separate(",");
+			}
+			count = alloc.allocate_function_parameter("count", "");
+			writer
+				.new_line()
+				.write_fmt("unsigned long long {}", count->get_name());
+		}
+		auto index = alloc.allocate_local_variable("i", "");
+		writer.write(" ");
+		auto scope = writer.begin_scope(cpp_writer::braces_scope);
+		writer
+			.new_line()
+			.write_fmt("for (unsigned long long {0} = 0; {0} < {1}; ++{0}) ", index->get_name(), count->get_name());
+		auto loop_scope = writer.begin_scope(cpp_writer::braces_scope);
+		writer.new_line();
+		if (has_results) {
+			writer.write_fmt("{}[{}] = ", results->get_name(), index->get_name());
+		}
+		// the implementation is in the same class, so the call and the callee can be inlined into the loop
+		writer.write(name.impl_name.get_cached());
+		{
+			auto call_scope = writer.begin_scope(cpp_writer::parentheses_scope);
+			for (auto &&token : param_tokens) {
+				writer
+					.write_fmt("{}[{}]", token->get_name(), index->get_name())
+					.maybe_separate(", ");
+			}
+		}
+		writer.write(";");
+	}
+
 	void exporter::_export_field_getter_impls(
 		cpp_writer &writer, entities::field_entity *entity, const field_naming &name
 	) const {
-		auto &type = entity->get_type();
 		auto parent_it = _record_names.find(entity->get_parent());
 		assert_true(parent_it != _record_names.end());
-		std::string_view exported_type_name = get_exported_type_name(type.type, type.type_entity);
+		std::string internal_parent_name =
+			writer.name_printer.get_internal_entity_name(entity->get_parent()->get_declaration());
 
 		if (entity->get_field_kind() == entities::field_kind::normal_field) { // non-const getter
 			name_allocator func_scope = name_allocator::from_parent_immutable(_impl_scope);
 			auto input = func_scope.allocate_function_parameter("object", "");
-			writer.write_fmt("inline static {} ", exported_type_name);
-			_export_api_field_getter_return_type_pointers_and_qualifiers(
-				writer, type, entity->get_field_kind(), false
-			);
+			writer.write("inline static ");
+			_export_api_field_getter_return_type(writer, entity, false);
 			writer.write_fmt(
 				"{}({} *{}) ",
 				name.getter_impl_name.get_cached(), parent_it->second.name.get_cached(), input->get_name()
@@ -386,17 +1347,14 @@ namespace apigen {
 				{
 					cpp_writer::scope_token cast_scope;
 					if (!entity->get_type().type->isBuiltinType()) {
-						writer.write_fmt("reinterpret_cast<{} ", exported_type_name);
-						_export_api_field_getter_return_type_pointers_and_qualifiers(
-							writer, type, entity->get_field_kind(), false
-						);
+						writer.write("reinterpret_cast<");
+						_export_api_field_getter_return_type(writer, entity, false);
 						writer.write(">");
 						cast_scope = writer.begin_scope(cpp_writer::parentheses_scope);
 					}
 					writer.write_fmt(
 						"&reinterpret_cast<{} *>({})->{}",
-						writer.name_printer.get_internal_entity_name(entity->get_parent()->get_declaration()),
-						input->get_name(), to_string_view(entity->get_declaration()->getName())
+						internal_parent_name, input->get_name(), to_string_view(entity->get_declaration()->getName())
 					);
 				}
 				writer.write(";");
@@ -407,10 +1365,8 @@ namespace apigen {
 		{ // const getter
 			name_allocator func_scope = name_allocator::from_parent_immutable(_impl_scope);
 			auto input = func_scope.allocate_function_parameter("object", "");
-			writer.write_fmt("inline static {} ", exported_type_name);
-			_export_api_field_getter_return_type_pointers_and_qualifiers(
-				writer, type, entity->get_field_kind(), true
-			);
+			writer.write("inline static ");
+			_export_api_field_getter_return_type(writer, entity, true);
 			writer.write_fmt(
 				"{}({} const *{}) ",
 				name.const_getter_impl_name.get_cached(), parent_it->second.name.get_cached(), input->get_name()
@@ -423,22 +1379,64 @@ namespace apigen {
 				{
 					cpp_writer::scope_token cast_scope;
 					if (!entity->get_type().type->isBuiltinType()) {
-						writer.write_fmt("reinterpret_cast<{} ", exported_type_name);
-						_export_api_field_getter_return_type_pointers_and_qualifiers(
-							writer, type, entity->get_field_kind(), true
-						);
+						writer.write("reinterpret_cast<");
+						_export_api_field_getter_return_type(writer, entity, true);
 						writer.write(">");
 						cast_scope = writer.begin_scope(cpp_writer::parentheses_scope);
 					}
 					writer.write_fmt(
 						"&reinterpret_cast<{} const *>({})->{}",
-						writer.name_printer.get_internal_entity_name(entity->get_parent()->get_declaration()),
-						input->get_name(), to_string_view(entity->get_declaration()->getName())
+						internal_parent_name, input->get_name(), to_string_view(entity->get_declaration()->getName())
 					);
 				}
 				writer.write(";");
 			}
 		}
+
+		if (!_is_typed_array(entity->get_type())) {
+			return;
+		}
+		// the elements are builtin types, enums, or vectors, so the whole array can be copied at once
+		std::string_view array_name = _array_type_names.at(_get_array_type_key(entity->get_type())).name.get_cached();
+		std::string_view field_name = to_string_view(entity->get_declaration()->getName());
+		{ // copy out
+			name_allocator func_scope = name_allocator::from_parent_immutable(_impl_scope);
+			auto input = func_scope.allocate_function_parameter("object", "");
+			auto output = func_scope.allocate_function_parameter("output", "");
+			writer
+				.new_line()
+				.write_fmt(
+					"inline static void {}({} const *{}, {} *{}) ",
+					name.copy_out_impl_name.get_cached(), parent_it->second.name.get_cached(), input->get_name(),
+					array_name, output->get_name()
+				);
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			writer
+				.new_line()
+				.write_fmt(
+					"::std::memcpy({}, &reinterpret_cast<{} const *>({})->{}, sizeof({}));",
+					output->get_name(), internal_parent_name, input->get_name(), field_name, array_name
+				);
+		}
+		if (entity->get_field_kind() == entities::field_kind::normal_field) { // copy in
+			name_allocator func_scope = name_allocator::from_parent_immutable(_impl_scope);
+			auto output = func_scope.allocate_function_parameter("object", "");
+			auto input = func_scope.allocate_function_parameter("input", "");
+			writer
+				.new_line()
+				.write_fmt(
+					"inline static void {}({} *{}, {} const *{}) ",
+					name.copy_in_impl_name.get_cached(), parent_it->second.name.get_cached(), output->get_name(),
+					array_name, input->get_name()
+				);
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			writer
+				.new_line()
+				.write_fmt(
+					"::std::memcpy(&reinterpret_cast<{} *>({})->{}, {}, sizeof({}));",
+					internal_parent_name, output->get_name(), field_name, input->get_name(), array_name
+				);
+		}
 	}
 
 	void exporter::_export_destructor_impl(
@@ -462,11 +1460,103 @@ namespace apigen {
 		}
 	}
 
+	void exporter::_export_record_view_impls(
+		cpp_writer &writer, entities::record_entity *entity, const record_naming &name
+	) const {
+		std::string internal_name = writer.name_printer.get_internal_entity_name(entity->get_declaration());
+		// enums are converted from and to the integer types in the API, and pointers to non-builtin types from and
+		// to the corresponding API pointers
+		auto get_cast = [](const qualified_type &type) -> std::string_view {
+			if (llvm::isa<clang::BuiltinType>(type.type) || llvm::isa<clang::VectorType>(type.type)) {
+				return "";
+			}
+			return type.qualifiers.size() == 1 ? "static_cast" : "reinterpret_cast";
+		};
+		{ // snapshot
+			name_allocator func_scope = name_allocator::from_parent_immutable(_impl_scope);
+			auto input = func_scope.allocate_function_parameter("object", "");
+			auto output = func_scope.allocate_function_parameter("view", "");
+			auto source = func_scope.allocate_local_variable("source", "");
+			writer.write_fmt(
+				"inline static void {}({} const *{}, {} *{}) ",
+				name.snapshot_impl_name.get_cached(), name.name.get_cached(), input->get_name(),
+				name.view_name.get_cached(), output->get_name()
+			);
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			writer
+				.new_line()
+				.write_fmt(
+					"{0} const &{1} = *reinterpret_cast<{0} const *>({2});",
+					internal_name, source->get_name(), input->get_name()
+				);
+			for (entities::field_entity *field : name.view_fields) {
+				std::string_view field_name = to_string_view(field->get_declaration()->getName());
+				writer
+					.new_line()
+					.write_fmt("{}->{} = ", output->get_name(), field_name);
+				std::string_view cast = get_cast(field->get_type());
+				if (cast.empty()) {
+					writer.write_fmt("{}.{};", source->get_name(), field_name);
+				} else {
+					writer.write_fmt("{}<", cast);
+					_export_api_view_field_type(writer, field);
+					writer.write_fmt(">({}.{});", source->get_name(), field_name);
+				}
+			}
+		}
+		if (!name.has_apply_function()) {
+			return;
+		}
+		{ // apply
+			name_allocator func_scope = name_allocator::from_parent_immutable(_impl_scope);
+			auto output = func_scope.allocate_function_parameter("object", "");
+			auto input = func_scope.allocate_function_parameter("view", "");
+			auto mask = func_scope.allocate_function_parameter("mask", "");
+			auto target = func_scope.allocate_local_variable("target", "");
+			writer
+				.new_line()
+				.write_fmt(
+					"inline static void {}({} *{}, {} const *{}, unsigned long long {}) ",
+					name.apply_impl_name.get_cached(), name.name.get_cached(), output->get_name(),
+					name.view_name.get_cached(), input->get_name(), mask->get_name()
+				);
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			writer
+				.new_line()
+				.write_fmt(
+					"{0} &{1} = *reinterpret_cast<{0} *>({2});", internal_name, target->get_name(), output->get_name()
+				);
+			for (std::size_t i = 0; i < name.view_fields.size(); ++i) {
+				entities::field_entity *field = name.view_fields[i];
+				if (!_is_view_field_writable(field)) {
+					continue;
+				}
+				std::string_view field_name = to_string_view(field->get_declaration()->getName());
+				writer
+					.new_line()
+					.write_fmt("if ({} & (1ull << {})) ", mask->get_name(), name.view_bit_names[i].get_cached());
+				auto if_scope = writer.begin_scope(cpp_writer::braces_scope);
+				writer
+					.new_line()
+					.write_fmt("{}.{} = ", target->get_name(), field_name);
+				std::string_view cast = get_cast(field->get_type());
+				if (cast.empty()) {
+					writer.write_fmt("{}->{};", input->get_name(), field_name);
+				} else {
+					qualified_type type = field->get_type();
+					type.qualifiers.front() = qualifier::none;
+					writer.write_fmt(
+						"{}<{}>({}->{});",
+						cast, writer.name_printer.get_internal_qualified_type_name(type), input->get_name(), field_name
+					);
+				}
+			}
+		}
+	}
+
 
 	// exporting of whole files
-	void exporter::export_api_header(std::ostream &out) const {
-		cpp_writer writer(out, printing_policy);
-
+	void exporter::_export_api_macros(cpp_writer &writer) const {
 		// a couple of definitions so that the user doesn't have to #include "apigen_definitions.h"
 		writer
 			.write("#define " APIGEN_STR(APIGEN_MOVED))
@@ -474,47 +1564,249 @@ namespace apigen {
 			.write("#define " APIGEN_STR(APIGEN_TEMPORARY))
 			.new_line()
 			.new_line();
+		if (export_record_layouts) {
+			writer
+				.write("#ifndef APIGEN_ALIGNAS")
+				.new_line()
+				.write("#	ifdef __cplusplus")
+				.new_line()
+				.write("#		define APIGEN_ALIGNAS(X) alignas(X)")
+				.new_line()
+				.write("#	else")
+				.new_line()
+				.write("#		define APIGEN_ALIGNAS(X) _Alignas(X)")
+				.new_line()
+				.write("#	endif")
+				.new_line()
+				.write("#endif")
+				.new_line()
+				.new_line();
+		}
+		if (inline_field_access) {
+			// functions with internal linkage cannot be exported from C++ modules
+			writer
+				.write("#ifndef APIGEN_INLINE")
+				.new_line()
+				.write("#	ifdef __cplusplus")
+				.new_line()
+				.write("#		define APIGEN_INLINE inline")
+				.new_line()
+				.write("#	else")
+				.new_line()
+				.write("#		define APIGEN_INLINE static inline")
+				.new_line()
+				.write("#	endif")
+				.new_line()
+				.write("#endif")
+				.new_line()
+				.new_line();
+		}
+	}
 
+	void exporter::_export_api_type_declarations(cpp_writer &writer) const {
+		_export_api_macros(writer);
+		for (auto &&[type, name] : _vector_type_names) {
+			_export_api_vector_type(writer, type, name);
+			writer
+				.new_line()
+				.new_line();
+		}
 		for (auto &&[ent, name] : _enum_names) {
 			_export_api_enum_type(writer, ent, name);
 			writer
 				.new_line()
 				.new_line();
 		}
+		for (auto &&[key, name] : _array_type_names) {
+			_export_api_array_type(writer, name);
+			writer
+				.new_line()
+				.new_line();
+		}
 		for (auto &&[ent, name] : _record_names) {
 			_export_api_type(writer, name);
 			writer
 				.new_line()
 				.new_line();
 		}
-
-		writer
-			.new_line()
-			.write_fmt("typedef struct {} ", naming->api_struct_name);
-		{
-			auto scope = writer.begin_scope(cpp_writer::braces_scope);
-			for (auto &&[ent, name] : _function_names) {
-				writer.new_line();
-				_export_api_function_pointer_definition(writer, ent, name);
-				writer.new_line();
+		for (auto &&[ent, name] : _record_names) {
+			if (!name.view_fields.empty()) {
+				_export_api_record_view(writer, name);
+				writer
+					.new_line()
+					.new_line();
 			}
-			for (auto &&[ent, name] : _record_names) {
-				writer.new_line();
-				_export_api_destructor_definition(writer, ent, name);
-				writer.new_line();
+		}
+		for (auto &&[ent, name] : _field_names) {
+			if (name.offset) {
+				_export_api_inline_field_accessors(writer, ent, name);
+				writer
+					.new_line()
+					.new_line();
 			}
-			for (auto &&[ent, name] : _field_names) {
-				writer.new_line();
-				_export_api_field_getter_definitions(writer, ent, name);
-				writer.new_line();
+		}
+	}
+
+	void exporter::_export_api_forward_declarations(cpp_writer &writer) const {
+		_export_api_macros(writer);
+		// types used in more than one group are declared here, and only defined if they can be used by value
+		for (auto &&[type, name] : _vector_type_names) {
+			_export_api_vector_type(writer, type, name);
+			writer
+				.new_line()
+				.new_line();
+		}
+		for (auto &&[ent, name] : _enum_names) {
+			_export_api_enum_typedef(writer, ent, name);
+			writer
+				.new_line()
+				.new_line();
+		}
+		for (auto &&[key, name] : _array_type_names) {
+			_export_api_array_type(writer, name);
+			writer
+				.new_line()
+				.new_line();
+		}
+		for (auto &&[ent, name] : _record_names) {
+			_export_api_record_declaration(writer, name);
+			writer
+				.new_line()
+				.new_line();
+		}
+	}
+
+	void exporter::_export_api_group_definitions(cpp_writer &writer, std::string_view group) const {
+		for (auto &&[ent, name] : _enum_names) {
+			if (_get_api_group(ent) == group) {
+				_export_api_enumerators(writer, name);
+				writer
+					.new_line()
+					.new_line();
 			}
-			for (auto &&[ent, name] : _custom_func_names) {
-				writer.new_line();
-				ent->export_pointer_declaration(writer, *this, name.api_name.get_cached());
-				writer.new_line();
+		}
+		for (auto &&[ent, name] : _record_names) {
+			if (name.size != 0 && _get_api_group(ent) == group) {
+				_export_api_record_layout(writer, name);
+				writer
+					.new_line()
+					.new_line();
+			}
+		}
+		for (auto &&[ent, name] : _record_names) {
+			if (!name.view_fields.empty() && _get_api_group(ent) == group) {
+				_export_api_record_view(writer, name);
+				writer
+					.new_line()
+					.new_line();
+			}
+		}
+		for (auto &&[ent, name] : _field_names) {
+			if (name.offset && _get_api_group(ent) == group) {
+				_export_api_inline_field_accessors(writer, ent, name);
+				writer
+					.new_line()
+					.new_line();
+			}
+		}
+	}
+
+	void exporter::_export_api_table(cpp_writer &writer, std::string_view struct_name, std::string_view group) const {
+		writer
+			.new_line()
+			.write_fmt("typedef struct {} ", struct_name);
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			if (group.empty() && slot_layout) {
+				_export_stable_api_table_members(writer);
+			} else {
+				if (group.empty()) { // sub-tables of all groups
+					for (auto &&[group_name, group_naming] : _api_groups) {
+						writer
+							.new_line()
+							.write_fmt(
+								"{} {};", group_naming.struct_name.get_cached(), group_naming.member_name.get_cached()
+							)
+							.new_line();
+					}
+				}
+				auto in_group = [this, group](auto *ent, auto&) {
+					return _get_api_group(ent) == group;
+				};
+				_export_fragments(writer, _function_names, [this](cpp_writer &w, auto *ent, auto &name) {
+					_export_api_function_pointer_definition(w, ent, name);
+					if (name.batch) {
+						w.new_line();
+						_export_api_batch_function_pointer_definition(w, ent, name);
+					}
+				}, in_group);
+				_export_fragments(writer, _record_names, [this](cpp_writer &w, auto *ent, auto &name) {
+					_export_api_destructor_definition(w, ent, name);
+					if (!name.view_fields.empty()) {
+						w.new_line();
+						_export_api_record_view_function_definition(w, name, false);
+						if (name.has_apply_function()) {
+							w.new_line();
+							_export_api_record_view_function_definition(w, name, true);
+						}
+					}
+				}, in_group);
+				_export_fragments(writer, _field_names, [this](cpp_writer &w, auto *ent, auto &name) {
+					_export_api_field_getter_definitions(w, ent, name);
+				}, in_group);
+				_export_fragments(writer, _custom_func_names, [this](cpp_writer &w, auto *ent, auto &name) {
+					ent->export_pointer_declaration(w, *this, name.api_name.get_cached());
+				}, in_group);
 			}
 		}
-		writer.write_fmt(" {};", naming->api_struct_name);
+		writer.write_fmt(" {};", struct_name);
+	}
+
+	void exporter::export_api_header(std::ostream &out) const {
+		cpp_writer writer(out, printing_policy);
+		if (split_api_header) {
+			_export_api_group_definitions(writer, "");
+		} else {
+			_export_api_type_declarations(writer);
+		}
+		_export_api_table(writer, naming->api_struct_name, "");
+		if (direct_link) {
+			_export_api_direct_declarations(writer, "");
+		}
+	}
+
+	void exporter::export_api_forward_header(std::ostream &out) const {
+		cpp_writer writer(out, printing_policy);
+		_export_api_forward_declarations(writer);
+	}
+
+	void exporter::export_api_group_header(std::ostream &out, std::string_view group) const {
+		cpp_writer writer(out, printing_policy);
+		auto it = _api_groups.find(group);
+		assert_true(it != _api_groups.end(), "unknown API group");
+		_export_api_group_definitions(writer, group);
+		_export_api_table(writer, it->second.struct_name.get_cached(), group);
+		if (direct_link) {
+			_export_api_direct_declarations(writer, group);
+		}
+	}
+
+	void exporter::export_api_module(
+		std::ostream &out, std::string_view module_name, std::string_view api_header_include
+	) const {
+		cpp_writer writer(out, printing_policy);
+		// declarations in a linkage specification are attached to the global module, so they're the same entities
+		// as those seen by clients that include the API header, and functions keep their C linkage
+		writer
+			.write_fmt("export module {};", module_name)
+			.new_line()
+			.new_line()
+			.write("export extern \"C++\" {")
+			.new_line()
+			.write_fmt("#include \"{}\"", api_header_include)
+			.new_line()
+			.write("}")
+			.new_line();
 	}
 
 	void exporter::export_host_h(std::ostream &out) const {
@@ -525,108 +1817,436 @@ namespace apigen {
 			.write_fmt("void {}({}&);", naming->api_struct_init_function_name, naming->api_struct_name);
 	}
 
-	void exporter::export_host_cpp(std::ostream &out) const {
-		cpp_writer writer(out, printing_policy);
-
-		// custom dependencies
+	void exporter::_export_host_custom_dependencies(cpp_writer &writer) const {
 		for (auto &header : _entities.get_custom_host_dependencies()) {
 			writer
 				.write_fmt("#include <{}>", header)
 				.new_line();
 		}
+	}
 
-		writer.write_fmt("struct {} ", APIGEN_API_CLASS_NAME_STR);
+	void exporter::_export_host_value_conversion(cpp_writer &writer) const {
+		bool any_value_record = std::any_of(_record_names.begin(), _record_names.end(), [](const auto &pair) {
+			return !pair.second.value_fields.empty();
+		});
+		if (!any_value_record) {
+			return;
+		}
+		// the storage is an array of unsigned char, so memcpy() implicitly creates the trivially copyable object
+		writer
+			.write("#include <cstring>")
+			.new_line()
+			.write("#include <new>")
+			.new_line()
+			.new_line()
+			.write_fmt("template <typename To, typename From> inline To {}(const From &from) ", _value_conversion_name);
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			writer
+				.new_line()
+				.write(R"(static_assert(sizeof(To) == sizeof(From), "mirrored records must have the same size");)")
+				.new_line()
+				.write("alignas(To) unsigned char storage[sizeof(To)];")
+				.new_line()
+				.write("::std::memcpy(storage, &from, sizeof(To));")
+				.new_line()
+				.write("return *::std::launder(reinterpret_cast<To*>(storage));");
+		}
+		writer
+			.new_line()
+			.new_line();
+	}
+
+	void exporter::_export_host_impls(cpp_writer &writer, std::string_view class_name, host_shard shard) const {
+		writer.write_fmt("struct {} ", class_name);
 		{
 			auto scope = writer.begin_scope(cpp_writer::braces_scope);
 			writer
 				.new_line()
 				.write("public:");
-			for (auto &&[ent, name] : _function_names) {
-				writer.new_line();
-				_export_function_impl(writer, ent, name);
-				writer.new_line();
+			if (shard.index == 0) {
+				_export_host_record_layout_checks(writer);
 			}
-			for (auto &&[ent, name] : _record_names) {
-				writer.new_line();
-				_export_destructor_impl(writer, ent, name);
-				writer.new_line();
+			auto in_shard = [shard](auto*, auto &name) {
+				return shard.contains(_get_host_shard_key(name));
+			};
+			_export_fragments(writer, _function_names, [this](cpp_writer &w, auto *ent, auto &name) {
+				_export_function_impl(w, ent, name);
+				if (name.batch) {
+					w.new_line();
+					_export_batch_function_impl(w, ent, name);
+				}
+			}, in_shard);
+			_export_fragments(writer, _record_names, [this](cpp_writer &w, auto *ent, auto &name) {
+				_export_destructor_impl(w, ent, name);
+				if (!name.view_fields.empty()) {
+					w.new_line();
+					_export_record_view_impls(w, ent, name);
+				}
+			}, in_shard);
+			_export_fragments(writer, _field_names, [this](cpp_writer &w, auto *ent, auto &name) {
+				_export_field_getter_impls(w, ent, name);
+			}, in_shard);
+			_export_fragments(writer, _custom_func_names, [this](cpp_writer &w, auto *ent, auto &name) {
+				ent->export_definition(w, *this, name.impl_name.get_cached());
+			}, in_shard);
+		}
+		writer
+			.write(";")
+			.new_line()
+			.new_line();
+	}
+
+	void exporter::_export_host_record_layout_checks(cpp_writer &writer) const {
+		// these are in the body of the befriended class so that privately exported records can be checked
+		for (auto &&[rec, name] : _record_names) {
+			std::string internal_name = writer.name_printer.get_internal_entity_name(rec->get_declaration());
+			if (!name.value_fields.empty()) {
+				writer
+					.new_line()
+					.write_fmt(
+						"static_assert(sizeof({0}) == sizeof({1}) && alignof({0}) == alignof({1}), "
+						"\"layout of {0} differs from the one of {1}\");",
+						internal_name, name.name.get_cached()
+					);
 			}
-			for (auto &&[ent, name] : _field_names) {
-				writer.new_line();
-				_export_field_getter_impls(writer, ent, name);
-				writer.new_line();
+			if (name.size == 0) {
+				continue;
 			}
-			for (auto &&[ent, name] : _custom_func_names) {
-				writer.new_line();
-				ent->export_definition(writer, *this, name.impl_name.get_cached());
-				writer.new_line();
+			writer
+				.new_line()
+				.write_fmt(
+					"static_assert(sizeof({0}) == {1}, \"size of {0} differs from the one in the API header\");",
+					internal_name, name.size_name.get_cached()
+				)
+				.new_line()
+				.write_fmt(
+					"static_assert(alignof({0}) == {1}, \"alignment of {0} differs from the one in the API header\");",
+					internal_name, name.align_name.get_cached()
+				);
+		}
+		std::unordered_map<const entities::record_entity*, std::string> aliases;
+		for (auto &&[field, name] : _field_names) {
+			if (!name.offset) {
+				continue;
+			}
+			std::string internal_name =
+				writer.name_printer.get_internal_entity_name(field->get_parent()->get_declaration());
+			auto [alias, inserted] = aliases.try_emplace(field->get_parent());
+			if (inserted) {
+				alias->second = get_host_layout_alias_name(aliases.size() - 1);
+				writer
+					.new_line()
+					.write_fmt("using {} = {};", alias->second, internal_name);
 			}
+			std::string_view field_name = to_string_view(field->get_declaration()->getName());
+			writer
+				.new_line()
+				.write_fmt(
+					"static_assert(offsetof({0}, {1}) == {2}, "
+					"\"offset of {3}::{1} differs from the one in the API header\");",
+					alias->second, field_name, name.offset.value(), internal_name
+				);
 		}
+		writer.new_line();
+	}
+
+	void exporter::_export_host_layout_init(cpp_writer &writer, std::string_view result_var) const {
 		writer
-			.write(";")
 			.new_line()
-			.new_line();
-		{
-			name_allocator alloc = name_allocator::from_parent_immutable(_global_scope);
-			auto result_var = alloc.allocate_function_parameter("result", "");
+			.write_fmt(
+				"{}.{} = static_cast<unsigned int>(sizeof({}));",
+				result_var, api_size_member_name, naming->api_struct_name
+			)
+			.new_line()
+			.write_fmt("{}.{} = {};", result_var, api_version_member_name, slot_layout->get_version());
+		const std::vector<slot_ledger::slot> &slots = slot_layout->get_slots();
+		for (std::size_t i = 0; i < slots.size(); ++i) {
+			if (slots[i].tombstone) {
+				writer
+					.new_line()
+					.write_fmt("{}.{} = nullptr;", result_var, get_tombstone_name(i));
+			}
+		}
+	}
 
-			writer.write_fmt(
-				"void {}({} &{}) ",
-				naming->api_struct_init_function_name,
-				naming->api_struct_name,
-				result_var->get_name()
-			);
-			{
-				auto scope = writer.begin_scope(cpp_writer::braces_scope);
-				for (auto &&[func, name] : _function_names) {
+	void exporter::_export_host_api_init(
+		cpp_writer &writer, std::string_view func_name, std::string_view class_name, host_shard shard
+	) const {
+		name_allocator alloc = name_allocator::from_parent_immutable(_global_scope);
+		auto result_var = alloc.allocate_function_parameter("result", "");
+
+		writer.write_fmt("void {}({} &{}) ", func_name, naming->api_struct_name, result_var->get_name());
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			if (slot_layout && shard.index == 0) {
+				_export_host_layout_init(writer, result_var->get_name());
+			}
+			for (auto &&[func, name] : _function_names) {
+				if (shard.contains(_get_host_shard_key(name))) {
 					writer
 						.new_line()
 						.write_fmt(
-							"{}.{} = {}::{};",
-							result_var->get_name(), name.api_name.get_cached(),
-							APIGEN_API_CLASS_NAME_STR, name.impl_name.get_cached()
+							"{}.{}{} = {}::{};",
+							result_var->get_name(), _get_api_table_member_prefix(_get_api_group(func)),
+							name.api_name.get_cached(),
+							class_name, name.impl_name.get_cached()
 						);
+					if (name.batch) {
+						writer
+							.new_line()
+							.write_fmt(
+								"{}.{}{} = {}::{};",
+								result_var->get_name(), _get_api_table_member_prefix(_get_api_group(func)),
+								name.batch_api_name.get_cached(),
+								class_name, name.batch_impl_name.get_cached()
+							);
+					}
 				}
-				for (auto &&[record, name] : _record_names) {
+			}
+			for (auto &&[record, name] : _record_names) {
+				if (shard.contains(_get_host_shard_key(name))) {
 					writer
 						.new_line()
 						.write_fmt(
-							"{}.{} = {}::{};",
-							result_var->get_name(), name.destructor_api_name.get_cached(),
-							APIGEN_API_CLASS_NAME_STR, name.destructor_impl_name.get_cached()
+							"{}.{}{} = {}::{};",
+							result_var->get_name(), _get_api_table_member_prefix(_get_api_group(record)),
+							name.destructor_api_name.get_cached(),
+							class_name, name.destructor_impl_name.get_cached()
 						);
-				}
-				for (auto &&[field, name] : _field_names) {
-					if (field->get_field_kind() == entities::field_kind::normal_field) {
+					if (!name.view_fields.empty()) {
+						std::string prefix = _get_api_table_member_prefix(_get_api_group(record));
 						writer
 							.new_line()
 							.write_fmt(
-								"{}.{} = {}::{};",
-								result_var->get_name(), name.getter_api_name.get_cached(),
-								APIGEN_API_CLASS_NAME_STR, name.getter_impl_name.get_cached()
+								"{}.{}{} = {}::{};",
+								result_var->get_name(), prefix, name.snapshot_api_name.get_cached(),
+								class_name, name.snapshot_impl_name.get_cached()
 							);
+						if (name.has_apply_function()) {
+							writer
+								.new_line()
+								.write_fmt(
+									"{}.{}{} = {}::{};",
+									result_var->get_name(), prefix, name.apply_api_name.get_cached(),
+									class_name, name.apply_impl_name.get_cached()
+								);
+						}
 					}
+				}
+			}
+			for (auto &&[field, name] : _field_names) {
+				if (!shard.contains(_get_host_shard_key(name))) {
+					continue;
+				}
+				std::string prefix = _get_api_table_member_prefix(_get_api_group(field));
+				if (field->get_field_kind() == entities::field_kind::normal_field) {
 					writer
 						.new_line()
 						.write_fmt(
-							"{}.{} = {}::{};",
-							result_var->get_name(), name.const_getter_api_name.get_cached(),
-							APIGEN_API_CLASS_NAME_STR, name.const_getter_impl_name.get_cached()
+							"{}.{}{} = {}::{};",
+							result_var->get_name(), prefix, name.getter_api_name.get_cached(),
+							class_name, name.getter_impl_name.get_cached()
 						);
 				}
-				for (auto &&[func, name] : _custom_func_names) {
+				writer
+					.new_line()
+					.write_fmt(
+						"{}.{}{} = {}::{};",
+						result_var->get_name(), prefix, name.const_getter_api_name.get_cached(),
+						class_name, name.const_getter_impl_name.get_cached()
+					);
+				if (_is_typed_array(field->get_type())) {
+					writer
+						.new_line()
+						.write_fmt(
+							"{}.{}{} = {}::{};",
+							result_var->get_name(), prefix, name.copy_out_api_name.get_cached(),
+							class_name, name.copy_out_impl_name.get_cached()
+						);
+					if (field->get_field_kind() == entities::field_kind::normal_field) {
+						writer
+							.new_line()
+							.write_fmt(
+								"{}.{}{} = {}::{};",
+								result_var->get_name(), prefix, name.copy_in_api_name.get_cached(),
+								class_name, name.copy_in_impl_name.get_cached()
+							);
+					}
+				}
+			}
+			for (auto &&[func, name] : _custom_func_names) {
+				if (shard.contains(_get_host_shard_key(name))) {
 					writer
 						.new_line()
 						.write_fmt(
 							"{}.{} = {}::{};",
 							result_var->get_name(), name.api_name.get_cached(),
-							APIGEN_API_CLASS_NAME_STR, name.impl_name.get_cached()
+							class_name, name.impl_name.get_cached()
 						);
 				}
 			}
 		}
 	}
 
+	void exporter::export_host_cpp(std::ostream &out) const {
+		cpp_writer writer(out, printing_policy);
+		_export_host_custom_dependencies(writer);
+		_export_host_value_conversion(writer);
+		_export_host_impls(writer, APIGEN_API_CLASS_NAME_STR, host_shard());
+		_export_host_api_init(writer, naming->api_struct_init_function_name, APIGEN_API_CLASS_NAME_STR, host_shard());
+		if (direct_link) {
+			_export_host_direct_functions(writer, APIGEN_API_CLASS_NAME_STR, host_shard());
+		}
+	}
+
+	void exporter::export_host_cpp_shard(std::ostream &out, host_shard shard) const {
+		cpp_writer writer(out, printing_policy);
+		_export_host_custom_dependencies(writer);
+		_export_host_value_conversion(writer);
+
+		// the enclosing class is identical in all shards, and the befriended class grants access to its nested
+		// classes, so private exports still work
+		writer.write_fmt("struct {} ", APIGEN_API_CLASS_NAME_STR);
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			for (std::size_t i = 0; i < shard.count; ++i) {
+				writer
+					.new_line()
+					.write_fmt("struct {};", get_host_shard_class_name(i));
+			}
+		}
+		writer
+			.write(";")
+			.new_line()
+			.new_line();
+
+		std::string class_name = fmt::format(
+			"{}::{}", APIGEN_API_CLASS_NAME_STR, get_host_shard_class_name(shard.index)
+		);
+		_export_host_impls(writer, class_name, shard);
+		_export_host_api_init(writer, get_host_shard_init_function_name(shard.index), class_name, shard);
+		if (direct_link) {
+			_export_host_direct_functions(writer, class_name, shard);
+		}
+	}
+
+	void exporter::export_host_cpp_shard_init(std::ostream &out, std::size_t count) const {
+		cpp_writer writer(out, printing_policy);
+		for (std::size_t i = 0; i < count; ++i) {
+			writer
+				.write_fmt("void {}({}&);", get_host_shard_init_function_name(i), naming->api_struct_name)
+				.new_line();
+		}
+		writer.new_line();
+
+		name_allocator alloc = name_allocator::from_parent_immutable(_global_scope);
+		auto result_var = alloc.allocate_function_parameter("result", "");
+		writer.write_fmt(
+			"void {}({} &{}) ", naming->api_struct_init_function_name, naming->api_struct_name, result_var->get_name()
+		);
+		{
+			auto scope = writer.begin_scope(cpp_writer::braces_scope);
+			for (std::size_t i = 0; i < count; ++i) {
+				writer
+					.new_line()
+					.write_fmt("{}({});", get_host_shard_init_function_name(i), result_var->get_name());
+			}
+		}
+	}
+
+	std::optional<std::pair<std::uint64_t, std::uint64_t>> exporter::get_record_layout(
+		const clang::CXXRecordDecl *decl
+	) {
+		// the layout is only known for complete non-dependent types
+		if (!decl->getDefinition() || decl->isDependentType() || decl->isInvalidDecl()) {
+			return std::nullopt;
+		}
+		clang::ASTContext &context = decl->getASTContext();
+		clang::QualType type = context.getRecordType(decl);
+		return std::make_pair(
+			static_cast<std::uint64_t>(context.getTypeSizeInChars(type).getQuantity()),
+			static_cast<std::uint64_t>(context.getTypeAlignInChars(type).getQuantity())
+		);
+	}
+
+	std::optional<std::uint64_t> exporter::get_field_offset(const clang::FieldDecl *field) {
+		auto *parent = llvm::dyn_cast<clang::CXXRecordDecl>(field->getParent());
+		if (!parent || !get_record_layout(parent) || !parent->isStandardLayout() || field->isBitField()) {
+			return std::nullopt;
+		}
+		clang::ASTContext &context = field->getASTContext();
+		return static_cast<std::uint64_t>(context.toCharUnitsFromBits(context.getFieldOffset(field)).getQuantity());
+	}
+
+	std::vector<std::string> exporter::_get_value_fields(
+		const clang::CXXRecordDecl *decl, std::uint64_t max_size, const clang::PrintingPolicy &policy
+	) {
+		auto layout = get_record_layout(decl);
+		if (!layout || layout->first > max_size) {
+			return {};
+		}
+		decl = decl->getDefinition();
+		// base classes cannot be expressed in C
+		if (!decl->isTriviallyCopyable() || !decl->isStandardLayout() || decl->isUnion() || decl->getNumBases() > 0) {
+			return {};
+		}
+		// the mirror is a plain C struct, so alignment and packing attributes, including #pragma pack, would be lost
+		if (
+			decl->hasAttr<clang::AlignedAttr>() || decl->hasAttr<clang::PackedAttr>() ||
+			decl->hasAttr<clang::MaxFieldAlignmentAttr>()
+		) {
+			return {};
+		}
+		clang::ASTContext &context = decl->getASTContext();
+		std::uint64_t natural_offset = 0, natural_alignment = 1;
+		std::vector<std::string> result;
+		for (const clang::FieldDecl *field : decl->fields()) {
+			if (field->isBitField() || field->getAccess() != clang::AS_public || field->getName().empty()) {
+				return {};
+			}
+			if (field->hasAttr<clang::AlignedAttr>() || field->hasAttr<clang::PackedAttr>()) {
+				return {};
+			}
+			// canonical types are used since typedefs are usually not available in C
+			clang::QualType type = field->getType().getCanonicalType();
+			const clang::Type *element = type.getTypePtr();
+			while (auto *array = llvm::dyn_cast<clang::ConstantArrayType>(element)) {
+				element = array->getElementType().getTypePtr();
+			}
+			if (auto *pointer = llvm::dyn_cast<clang::PointerType>(element)) {
+				element = pointer->getPointeeType().getTypePtr();
+				if (element->isVoidType()) {
+					element = nullptr;
+				}
+			}
+			if (element && !(llvm::isa<clang::BuiltinType>(element) && element->isArithmeticType())) {
+				return {};
+			}
+			// the canonical type also drops alignment attributes of typedefs, so the offsets are checked against
+			// those in a C struct with the printed declarations
+			auto field_alignment = static_cast<std::uint64_t>(context.getTypeAlignInChars(type).getQuantity());
+			natural_offset = (natural_offset + field_alignment - 1) / field_alignment * field_alignment;
+			natural_alignment = std::max(natural_alignment, field_alignment);
+			auto offset = static_cast<std::uint64_t>(
+				context.toCharUnitsFromBits(context.getFieldOffset(field)).getQuantity()
+			);
+			if (offset != natural_offset) {
+				return {};
+			}
+			natural_offset += static_cast<std::uint64_t>(context.getTypeSizeInChars(type).getQuantity());
+			std::string &declaration = result.emplace_back();
+			llvm::raw_string_ostream stream(declaration);
+			type.print(stream, policy, field->getName());
+			stream.flush();
+		}
+		natural_offset = (natural_offset + natural_alignment - 1) / natural_alignment * natural_alignment;
+		if (layout->first != natural_offset || layout->second != natural_alignment) {
+			return {};
+		}
+		return result;
+	}
+
 	/// Type declaration for record type size and alignment data.
 	const std::string_view _size_alignment_type_decl = "const size_t "; // TODO is this good practice?
 	void exporter::export_data_collection_cpp(std::ostream &out) const {
@@ -640,15 +2260,18 @@ namespace apigen {
 		{
 			auto scope = writer.begin_scope(cpp_writer::braces_scope);
 			for (auto &&[rec, name] : _record_names) {
+				if (name.size != 0) { // already defined in the API header
+					continue;
+				}
 				std::string internal_name = writer.name_printer.get_internal_entity_name(rec->get_declaration());
 				writer
 					.new_line()
 					.write_fmt(R"(std::cout << "{})", _size_alignment_type_decl)
-					.write_fmt(naming->size_name_pattern, name.name.get_cached())
+					.write(name.size_name.get_cached())
 					.write_fmt(R"( = " << sizeof({}) << ";\n";)", internal_name)
 					.new_line()
 					.write_fmt(R"(std::cout << "{})", _size_alignment_type_decl)
-					.write_fmt(naming->align_name_pattern, name.name.get_cached())
+					.write(name.align_name.get_cached())
 					.write_fmt(R"( = " << alignof({}) << ";\n\n";)", internal_name)
 					.new_line();
 			}
@@ -657,4 +2280,556 @@ namespace apigen {
 				.write("return 0;");
 		}
 	}
+
+
+	// direct linking
+	std::vector<exporter::_direct_function> exporter::_get_direct_functions() const {
+		auto render = [this](const auto &func) {
+			cpp_writer writer(printing_policy);
+			func(writer);
+			return std::string(writer.get_buffered_contents());
+		};
+
+		std::vector<_direct_function> result;
+		for (auto &&[ent, name] : _function_names) {
+			_direct_function &func = result.emplace_back();
+			func.api_name = name.api_name.get_cached();
+			func.impl_name = name.impl_name.get_cached();
+			func.shard_key = _get_host_shard_key(name);
+			func.group = _get_api_group(ent);
+			auto &return_type = ent->get_api_return_type();
+			if (return_type) {
+				func.return_type = render([&](cpp_writer &w) {
+					export_api_return_type(w, return_type.value());
+				});
+			} else {
+				func.return_type = "void ";
+			}
+			for (auto &&param : ent->get_parameters()) {
+				func.parameter_types.emplace_back(render([&](cpp_writer &w) {
+					export_api_parameter_type(w, param.type, true);
+				}));
+			}
+			if (return_type && return_type->is_record_type() && !is_passed_by_value(return_type.value())) {
+				func.parameter_types.emplace_back("void*");
+			}
+			if (!name.batch) {
+				continue;
+			}
+			_direct_function &batch = result.emplace_back();
+			batch.api_name = name.batch_api_name.get_cached();
+			batch.impl_name = name.batch_impl_name.get_cached();
+			batch.shard_key = _get_host_shard_key(name);
+			batch.group = _get_api_group(ent);
+			batch.return_type = "void ";
+			for (auto &&param : ent->get_parameters()) {
+				batch.parameter_types.emplace_back(render([&](cpp_writer &w) {
+					export_api_parameter_type(w, _get_batch_array_type(param.type, true), false);
+				}));
+			}
+			if (return_type && !return_type->is_void()) {
+				batch.parameter_types.emplace_back(render([&](cpp_writer &w) {
+					export_api_return_type(w, _get_batch_array_type(return_type.value(), false));
+				}));
+			}
+			batch.parameter_types.emplace_back("unsigned long long");
+		}
+		for (auto &&[ent, name] : _record_names) {
+			_direct_function &func = result.emplace_back();
+			func.api_name = name.destructor_api_name.get_cached();
+			func.impl_name = name.destructor_impl_name.get_cached();
+			func.shard_key = _get_host_shard_key(name);
+			func.group = _get_api_group(ent);
+			func.return_type = "void ";
+			func.parameter_types.emplace_back(fmt::format("{} *", name.name.get_cached()));
+			if (name.view_fields.empty()) {
+				continue;
+			}
+			_direct_function &snapshot = result.emplace_back();
+			snapshot.api_name = name.snapshot_api_name.get_cached();
+			snapshot.impl_name = name.snapshot_impl_name.get_cached();
+			snapshot.shard_key = _get_host_shard_key(name);
+			snapshot.group = _get_api_group(ent);
+			snapshot.return_type = "void ";
+			snapshot.parameter_types.emplace_back(fmt::format("{} const *", name.name.get_cached()));
+			snapshot.parameter_types.emplace_back(fmt::format("{} *", name.view_name.get_cached()));
+			if (name.has_apply_function()) {
+				_direct_function &apply = result.emplace_back();
+				apply.api_name = name.apply_api_name.get_cached();
+				apply.impl_name = name.apply_impl_name.get_cached();
+				apply.shard_key = _get_host_shard_key(name);
+				apply.group = _get_api_group(ent);
+				apply.return_type = "void ";
+				apply.parameter_types.emplace_back(fmt::format("{} *", name.name.get_cached()));
+				apply.parameter_types.emplace_back(fmt::format("{} const *", name.view_name.get_cached()));
+				apply.parameter_types.emplace_back("unsigned long long");
+			}
+		}
+		for (auto &&[ent, name] : _field_names) {
+			auto parent_it = _record_names.find(ent->get_parent());
+			assert_true(parent_it != _record_names.end());
+			auto add_getter = [&](const cached_name &api_name, const cached_name &impl_name, bool is_const) {
+				_direct_function &func = result.emplace_back();
+				func.api_name = api_name.get_cached();
+				func.impl_name = impl_name.get_cached();
+				func.shard_key = _get_host_shard_key(name);
+				func.group = _get_api_group(ent);
+				func.return_type = render([&](cpp_writer &w) {
+					_export_api_field_getter_return_type(w, ent, is_const);
+				});
+				func.parameter_types.emplace_back(fmt::format(
+					"{} {}*", parent_it->second.name.get_cached(), is_const ? "const " : ""
+				));
+			};
+			// only normal fields have non-const getters
+			if (ent->get_field_kind() == entities::field_kind::normal_field) {
+				add_getter(name.getter_api_name, name.getter_impl_name, false);
+			}
+			add_getter(name.const_getter_api_name, name.const_getter_impl_name, true);
+			if (_is_typed_array(ent->get_type())) {
+				std::string_view array_name =
+					_array_type_names.at(_get_array_type_key(ent->get_type())).name.get_cached();
+				auto add_copy = [&](const cached_name &api_name, const cached_name &impl_name, bool copy_in) {
+					_direct_function &func = result.emplace_back();
+					func.api_name = api_name.get_cached();
+					func.impl_name = impl_name.get_cached();
+					func.shard_key = _get_host_shard_key(name);
+					func.group = _get_api_group(ent);
+					func.return_type = "void ";
+					func.parameter_types.emplace_back(fmt::format(
+						"{} {}*", parent_it->second.name.get_cached(), copy_in ? "" : "const "
+					));
+					func.parameter_types.emplace_back(fmt::format("{} {}*", array_name, copy_in ? "const " : ""));
+				};
+				add_copy(name.copy_out_api_name, name.copy_out_impl_name, false);
+				if (ent->get_field_kind() == entities::field_kind::normal_field) {
+					add_copy(name.copy_in_api_name, name.copy_in_impl_name, true);
+				}
+			}
+		}
+		return result;
+	}
+
+	void exporter::_export_api_direct_declarations(cpp_writer &writer, std::string_view group) const {
+		std::vector<_direct_function> funcs = _get_direct_functions();
+		funcs.erase(std::remove_if(funcs.begin(), funcs.end(), [group](const _direct_function &func) {
+			return func.group != group;
+		}), funcs.end());
+		if (funcs.empty()) {
+			return;
+		}
+
+		writer
+			.new_line()
+			.new_line()
+			.write("#ifdef __cplusplus")
+			.new_line()
+			.write("extern \"C\" {")
+			.new_line()
+			.write("#endif");
+		for (const _direct_function &func : funcs) {
+			std::string_view name = _direct_names.at(func.api_name).get_cached();
+			writer
+				.new_line()
+				.write(_direct_function::get_declaration(func.return_type, name));
+			{
+				auto scope = writer.begin_scope(cpp_writer::parentheses_scope);
+				for (const std::string &param : func.parameter_types) {
+					writer
+						.write(std::string_view(param).substr(0, param.find_last_not_of(' ') + 1))
+						.maybe_separate(", ");
+				}
+			}
+			writer.write(";");
+		}
+		writer
+			.new_line()
+			.write("#ifdef __cplusplus")
+			.new_line()
+			.write("}")
+			.new_line()
+			.write("#endif")
+			.new_line();
+	}
+
+	void exporter::_export_host_direct_functions(
+		cpp_writer &writer, std::string_view class_name, host_shard shard
+	) const {
+		for (const _direct_function &func : _get_direct_functions()) {
+			if (!shard.contains(func.shard_key)) {
+				continue;
+			}
+			name_allocator alloc = name_allocator::from_parent_immutable(_global_scope);
+			std::vector<name_allocator::token> param_tokens;
+			std::string_view name = _direct_names.at(func.api_name).get_cached();
+			writer
+				.new_line()
+				.new_line()
+				.write("extern \"C\" ")
+				.write(_direct_function::get_declaration(func.return_type, name));
+			{
+				auto scope = writer.begin_scope(cpp_writer::parentheses_scope);
+				for (std::size_t i = 0; i < func.parameter_types.size(); ++i) {
+					auto &token = param_tokens.emplace_back(alloc.allocate_function_parameter(std::to_string(i), ""));
+					writer
+						.write(_direct_function::get_declaration(func.parameter_types[i], token->get_name()))
+						.maybe_separate(", ");
+				}
+			}
+			writer.write(" ");
+			{
+				auto scope = writer.begin_scope(cpp_writer::braces_scope);
+				writer
+					.new_line()
+					.write_fmt("return {}::{}", class_name, func.impl_name);
+				{
+					auto args_scope = writer.begin_scope(cpp_writer::parentheses_scope);
+					for (auto &token : param_tokens) {
+						writer
+							.write(token->get_name())
+							.maybe_separate(", ");
+					}
+				}
+				writer.write(";");
+			}
+		}
+		writer.new_line();
+	}
+
+
+	// manifest
+	api_manifest::type_info exporter::_get_manifest_type(const qualified_type &type) const {
+		api_manifest::type_info result;
+		if (_is_typed_array(type)) { // described by the array typedef and the qualifiers of its elements
+			result.name = std::string(_array_type_names.at(_get_array_type_key(type)).name.get_cached());
+			result.category = api_manifest::type_category::array;
+			result.qualifiers.emplace_back(static_cast<std::uint8_t>(type.get_element_qualifiers()));
+			return result;
+		}
+		result.name = std::string(get_exported_type_name(type.type, type.type_entity));
+		if (llvm::isa<clang::EnumType>(type.type)) {
+			result.category = api_manifest::type_category::enumeration;
+		} else if (llvm::isa<clang::RecordType>(type.type)) {
+			result.category = api_manifest::type_category::record;
+		} else if (llvm::isa<clang::VectorType>(type.type)) {
+			result.category = api_manifest::type_category::vector;
+		}
+		switch (type.ref_kind) {
+		case reference_kind::none:
+			break;
+		case reference_kind::reference:
+			result.reference = api_manifest::reference_kind::reference;
+			break;
+		case reference_kind::rvalue_reference:
+			result.reference = api_manifest::reference_kind::rvalue_reference;
+			break;
+		}
+		for (qualifier qual : type.qualifiers) {
+			result.qualifiers.emplace_back(static_cast<std::uint8_t>(qual));
+		}
+		return result;
+	}
+
+	api_manifest::table_info exporter::_build_manifest_table(
+		std::string_view struct_name, std::string_view group
+	) const {
+		internal_name_printer name_printer(printing_policy);
+		api_manifest::table_info result;
+		result.name = std::string(struct_name);
+		result.group = std::string(group);
+
+		// the slots are in the same order as the members of the structure exported by _export_api_table()
+		if (group.empty()) {
+			for (auto &&[group_name, group_naming] : _api_groups) {
+				api_manifest::slot_info &slot = result.slots.emplace_back();
+				slot.name = std::string(group_naming.member_name.get_cached());
+				slot.entity = std::string(group_naming.struct_name.get_cached());
+				slot.kind = api_manifest::slot_kind::table;
+			}
+		}
+		for (auto &&[ent, name] : _function_names) {
+			if (_get_api_group(ent) != group) {
+				continue;
+			}
+			api_manifest::slot_info &slot = result.slots.emplace_back();
+			slot.name = std::string(name.api_name.get_cached());
+			slot.entity = name_printer.get_internal_entity_name(ent->get_declaration());
+			if (auto &return_type = ent->get_api_return_type(); return_type && !return_type->is_void()) {
+				slot.return_type = _get_manifest_type(return_type.value());
+				if (return_type->is_reference_or_pointer()) {
+					slot.return_passing = api_manifest::passing_mode::reference;
+				} else if (return_type->is_record_type() && !is_passed_by_value(return_type.value())) {
+					slot.return_passing = api_manifest::passing_mode::output;
+				}
+			}
+			for (auto &&param : ent->get_parameters()) {
+				api_manifest::parameter_info &param_info = slot.parameters.emplace_back();
+				param_info.name = param.name;
+				param_info.type = _get_manifest_type(param.type);
+				if (param.type.is_reference_or_pointer()) {
+					param_info.passing = api_manifest::passing_mode::reference;
+				} else if (is_passed_by_value(param.type)) {
+					param_info.passing = api_manifest::passing_mode::value;
+				} else if (auto *record = dyn_cast<entities::record_entity>(param.type.type_entity)) {
+					param_info.passing =
+						record->has_move_constructor() ?
+						api_manifest::passing_mode::moved :
+						api_manifest::passing_mode::copied;
+				}
+			}
+			if (!name.batch) {
+				continue;
+			}
+			api_manifest::slot_info &batch = result.slots.emplace_back();
+			batch.name = std::string(name.batch_api_name.get_cached());
+			batch.entity = name_printer.get_internal_entity_name(ent->get_declaration());
+			batch.kind = api_manifest::slot_kind::function_batch;
+			for (auto &&param : ent->get_parameters()) {
+				api_manifest::parameter_info &param_info = batch.parameters.emplace_back();
+				param_info.name = param.name;
+				param_info.type = _get_manifest_type(_get_batch_array_type(param.type, true));
+				param_info.passing = api_manifest::passing_mode::reference;
+			}
+			if (auto &return_type = ent->get_api_return_type(); return_type && !return_type->is_void()) {
+				api_manifest::parameter_info &results = batch.parameters.emplace_back();
+				results.name = "results";
+				results.type = _get_manifest_type(_get_batch_array_type(return_type.value(), false));
+				results.passing = api_manifest::passing_mode::reference;
+			}
+			api_manifest::parameter_info &count = batch.parameters.emplace_back();
+			count.name = "count";
+			count.type.name = "unsigned long long";
+			count.type.qualifiers = { 0 };
+		}
+		for (auto &&[ent, name] : _record_names) {
+			if (_get_api_group(ent) != group) {
+				continue;
+			}
+			api_manifest::slot_info &slot = result.slots.emplace_back();
+			slot.name = std::string(name.destructor_api_name.get_cached());
+			slot.entity = name_printer.get_internal_entity_name(ent->get_declaration());
+			slot.kind = api_manifest::slot_kind::destructor;
+			api_manifest::parameter_info &param = slot.parameters.emplace_back();
+			param.type.name = std::string(name.name.get_cached());
+			param.type.category = api_manifest::type_category::record;
+			param.type.qualifiers = { 0, 0 };
+			param.passing = api_manifest::passing_mode::reference;
+			if (name.view_fields.empty()) {
+				continue;
+			}
+			auto add_view_function = [&](const cached_name &func_name, api_manifest::slot_kind kind, bool apply) {
+				api_manifest::slot_info &view_slot = result.slots.emplace_back();
+				view_slot.name = std::string(func_name.get_cached());
+				view_slot.entity = name_printer.get_internal_entity_name(ent->get_declaration());
+				view_slot.kind = kind;
+				api_manifest::parameter_info &object = view_slot.parameters.emplace_back();
+				object.type.name = std::string(name.name.get_cached());
+				object.type.category = api_manifest::type_category::record;
+				object.type.qualifiers = { 0, static_cast<std::uint8_t>(apply ? 0 : api_manifest::const_qualifier) };
+				object.passing = api_manifest::passing_mode::reference;
+				api_manifest::parameter_info &view = view_slot.parameters.emplace_back();
+				view.type.name = std::string(name.view_name.get_cached());
+				view.type.category = api_manifest::type_category::view;
+				view.type.qualifiers = { 0, static_cast<std::uint8_t>(apply ? api_manifest::const_qualifier : 0) };
+				view.passing = api_manifest::passing_mode::reference;
+				if (apply) {
+					api_manifest::parameter_info &mask = view_slot.parameters.emplace_back();
+					mask.type.name = "unsigned long long";
+					mask.type.qualifiers = { 0 };
+				}
+			};
+			add_view_function(name.snapshot_api_name, api_manifest::slot_kind::record_snapshot, false);
+			if (name.has_apply_function()) {
+				add_view_function(name.apply_api_name, api_manifest::slot_kind::record_apply, true);
+			}
+		}
+		for (auto &&[ent, name] : _field_names) {
+			if (_get_api_group(ent) != group) {
+				continue;
+			}
+			api_manifest::field_kind field = api_manifest::field_kind::normal;
+			switch (ent->get_field_kind()) {
+			case entities::field_kind::normal_field:
+				break;
+			case entities::field_kind::reference_field:
+				field = api_manifest::field_kind::reference;
+				break;
+			case entities::field_kind::const_field:
+				field = api_manifest::field_kind::constant;
+				break;
+			case entities::field_kind::mutable_field:
+				field = api_manifest::field_kind::mutable_field;
+				break;
+			}
+			auto parent_it = _record_names.find(ent->get_parent());
+			assert_true(parent_it != _record_names.end());
+			std::string entity_name =
+				name_printer.get_internal_entity_name(ent->get_parent()->get_declaration()) +
+				"::" + ent->get_declaration()->getNameAsString();
+			auto add_getter = [&](const cached_name &getter_name, api_manifest::slot_kind kind, bool is_const) {
+				api_manifest::slot_info &slot = result.slots.emplace_back();
+				slot.name = std::string(getter_name.get_cached());
+				slot.entity = entity_name;
+				slot.kind = kind;
+				slot.field = field;
+				slot.return_type = _get_manifest_type(ent->get_type());
+				slot.return_passing = api_manifest::passing_mode::reference;
+				api_manifest::parameter_info &param = slot.parameters.emplace_back();
+				param.type.name = std::string(parent_it->second.name.get_cached());
+				param.type.category = api_manifest::type_category::record;
+				param.type.qualifiers = { 0, static_cast<std::uint8_t>(is_const ? api_manifest::const_qualifier : 0) };
+				param.passing = api_manifest::passing_mode::reference;
+			};
+			// only normal fields have non-const getters
+			if (ent->get_field_kind() == entities::field_kind::normal_field) {
+				add_getter(name.getter_api_name, api_manifest::slot_kind::field_getter, false);
+			}
+			add_getter(name.const_getter_api_name, api_manifest::slot_kind::field_const_getter, true);
+			if (_is_typed_array(ent->get_type())) {
+				auto add_copy = [&](const cached_name &copy_name, api_manifest::slot_kind kind, bool copy_in) {
+					api_manifest::slot_info &slot = result.slots.emplace_back();
+					slot.name = std::string(copy_name.get_cached());
+					slot.entity = entity_name;
+					slot.kind = kind;
+					slot.field = field;
+					api_manifest::parameter_info &object = slot.parameters.emplace_back();
+					object.type.name = std::string(parent_it->second.name.get_cached());
+					object.type.category = api_manifest::type_category::record;
+					object.type.qualifiers = {
+						0, static_cast<std::uint8_t>(copy_in ? 0 : api_manifest::const_qualifier)
+					};
+					object.passing = api_manifest::passing_mode::reference;
+					api_manifest::parameter_info &array = slot.parameters.emplace_back();
+					array.type.name = std::string(
+						_array_type_names.at(_get_array_type_key(ent->get_type())).name.get_cached()
+					);
+					array.type.category = api_manifest::type_category::array;
+					array.type.qualifiers = {
+						0, static_cast<std::uint8_t>(copy_in ? api_manifest::const_qualifier : 0)
+					};
+					array.passing = api_manifest::passing_mode::reference;
+				};
+				add_copy(name.copy_out_api_name, api_manifest::slot_kind::field_copy_out, false);
+				if (ent->get_field_kind() == entities::field_kind::normal_field) {
+					add_copy(name.copy_in_api_name, api_manifest::slot_kind::field_copy_in, true);
+				}
+			}
+		}
+		for (auto &&[ent, name] : _custom_func_names) {
+			if (_get_api_group(ent) != group) {
+				continue;
+			}
+			api_manifest::slot_info &slot = result.slots.emplace_back();
+			slot.name = std::string(name.api_name.get_cached());
+			slot.entity = std::string(name.impl_name.get_cached());
+			slot.kind = api_manifest::slot_kind::custom_function;
+			// rendering the declaration without a name gives the type of the function pointer
+			cpp_writer writer(printing_policy);
+			ent->export_pointer_declaration(writer, *this, "");
+			std::string_view signature = writer.get_buffered_contents();
+			if (!signature.empty() && signature.back() == ';') {
+				signature.remove_suffix(1);
+			}
+			slot.signature = std::string(signature);
+		}
+
+		if (group.empty() && slot_layout) { // reorder the slots to match the stable layout
+			std::unordered_map<std::string_view, api_manifest::slot_info*> slots_by_name;
+			for (api_manifest::slot_info &slot : result.slots) {
+				slots_by_name.emplace(slot.name, &slot);
+			}
+			std::vector<api_manifest::slot_info> ordered;
+			const std::vector<slot_ledger::slot> &layout = slot_layout->get_slots();
+			for (std::size_t i = 0; i < layout.size(); ++i) {
+				if (layout[i].tombstone) {
+					api_manifest::slot_info &slot = ordered.emplace_back();
+					slot.name = get_tombstone_name(i);
+					slot.entity = layout[i].name;
+					slot.kind = api_manifest::slot_kind::tombstone;
+				} else {
+					auto it = slots_by_name.find(layout[i].name);
+					assert_true(it != slots_by_name.end(), "slot ledger is out of date");
+					ordered.emplace_back(*it->second);
+				}
+			}
+			result.slots = std::move(ordered);
+		}
+		return result;
+	}
+
+	void exporter::_build_manifest_view(api_manifest::record_info &rec, const record_naming &name) const {
+		rec.view_name = std::string(name.view_name.get_cached());
+		std::uint64_t offset = 0, alignment = 1;
+		for (entities::field_entity *field : name.view_fields) {
+			clang::ASTContext &context = field->get_declaration()->getASTContext();
+			clang::QualType type = field->get_declaration()->getType();
+			auto field_size = static_cast<std::uint64_t>(context.getTypeSizeInChars(type).getQuantity());
+			auto field_alignment = static_cast<std::uint64_t>(context.getTypeAlignInChars(type).getQuantity());
+			offset = (offset + field_alignment - 1) / field_alignment * field_alignment;
+			alignment = std::max(alignment, field_alignment);
+
+			api_manifest::field_info &field_info = rec.view_fields.emplace_back();
+			field_info.name = field->get_declaration()->getNameAsString();
+			cpp_writer writer(printing_policy);
+			_export_api_view_field_type(writer, field);
+			writer.write(field_info.name);
+			field_info.declaration = std::string(writer.get_buffered_contents());
+			field_info.offset = offset;
+			offset += field_size;
+		}
+		rec.view_size = (offset + alignment - 1) / alignment * alignment;
+	}
+
+	api_manifest exporter::build_manifest() const {
+		internal_name_printer name_printer(printing_policy);
+		api_manifest result;
+		result.tables.emplace_back(_build_manifest_table(naming->api_struct_name, ""));
+		for (auto &&[group, group_naming] : _api_groups) {
+			result.tables.emplace_back(_build_manifest_table(group_naming.struct_name.get_cached(), group));
+		}
+		std::unordered_map<const entities::record_entity*, std::size_t> record_indices;
+		for (auto &&[ent, name] : _record_names) {
+			record_indices.emplace(ent, result.records.size());
+			api_manifest::record_info &rec = result.records.emplace_back();
+			rec.name = std::string(name.name.get_cached());
+			rec.internal_name = name_printer.get_internal_entity_name(ent->get_declaration());
+			rec.movable = ent->has_move_constructor();
+			if (auto layout = get_record_layout(ent->get_declaration())) {
+				std::tie(rec.size, rec.alignment) = layout.value();
+			}
+			if (!name.value_fields.empty()) {
+				// value fields are the declarations of all fields in declaration order
+				auto field_it = ent->get_declaration()->getDefinition()->field_begin();
+				for (const std::string &declaration : name.value_fields) {
+					api_manifest::field_info &field = rec.value_fields.emplace_back();
+					field.name = field_it->getNameAsString();
+					field.declaration = declaration;
+					field.offset = get_field_offset(*field_it).value();
+					++field_it;
+				}
+			}
+			if (!name.view_fields.empty()) {
+				_build_manifest_view(rec, name);
+			}
+		}
+		for (auto &&[ent, name] : _field_names) {
+			if (!name.offset) {
+				continue;
+			}
+			api_manifest::record_info &rec = result.records[record_indices.at(ent->get_parent())];
+			api_manifest::field_info &field = rec.inline_fields.emplace_back();
+			field.name = ent->get_declaration()->getNameAsString();
+			field.offset = name.offset.value();
+		}
+		for (auto &&[ent, name] : _enum_names) {
+			api_manifest::enum_info &enumeration = result.enums.emplace_back();
+			enumeration.name = std::string(name.name.get_cached());
+			enumeration.internal_name = name_printer.get_internal_entity_name(ent->get_declaration());
+			enumeration.underlying_type = std::string(get_exported_type_name(ent->get_integer_type(), nullptr));
+			for (auto &&[value, enumerator_name] : name.enumerators) {
+				enumeration.enumerators.push_back({ std::string(enumerator_name.get_cached()), value });
+			}
+		}
+		return result;
+	}
 }
@@ -3,9 +3,14 @@
 /// \file
 /// Used to generate the exported code.
 
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <optional>
+#include <set>
 #include <sstream>
-#include <variant>
+#include <tuple>
+#include <unordered_map>
 
 #include <fmt/ostream.h> // TODO C++20
 
@@ -13,9 +18,13 @@
 #include "entity_kinds/field_entity.h"
 #include "entity_kinds/user_type_entity.h"
 #include "entity_registry.h"
+#include "logger.h"
 #include "cpp_writer.h"
 #include "naming_convention.h"
 #include "internal_name_printer.h"
+#include "manifest.h"
+#include "name_ledger.h"
+#include "slot_ledger.h"
 #include "parser.h"
 
 namespace apigen {
@@ -28,26 +37,37 @@ namespace apigen {
 			/// Default constructor.
 			cached_name() = default;
 			/// Initializes this name using the given \ref name_allocator::token.
-			explicit cached_name(name_allocator::token tok) :
-				_data(std::in_place_type<name_allocator::token>, std::move(tok)) {
+			explicit cached_name(name_allocator::token tok) : _token(std::move(tok)) {
 			}
 
-			/// Concatenates the parts of the name and caches it for later use.
+			/// Concatenates the parts of the name and caches it for later use. The name will not be changed by
+			/// subsequent allocations afterwards.
 			void freeze() {
-				if (std::holds_alternative<name_allocator::token>(_data)) {
-					std::string str = std::get<name_allocator::token>(_data)->get_name();
-					_data.emplace<std::string>(std::move(str));
+				if (_token && !_frozen) {
+					_token->fixed = true;
+					_cached = _token->get_name();
+					_frozen = true;
 				}
 			}
 			/// Returns the name. This should only be called after this name has been frozen.
 			[[nodiscard]] std::string_view get_cached() const {
-				return std::get<std::string>(_data);
+				assert_true(_frozen || !_token, "name accessed before it's frozen");
+				return _cached;
+			}
+			/// Returns the underlying \ref name_allocator::name_info.
+			[[nodiscard]] const name_allocator::name_info *get_info() const {
+				return _token.get();
 			}
 
 			/// Registers the given name to the \ref name_allocator, and returns the resulting \ref cached_name.
 			[[nodiscard]] inline static cached_name register_name(
 				name_allocator &alloc, naming_convention::name_info name
 			) {
+				if (name.lazy_disambiguation) {
+					return cached_name(alloc.allocate_variable_custom(
+						std::move(name.name), std::move(name.lazy_disambiguation)
+					));
+				}
 				return cached_name(alloc.allocate_variable_custom(
 					std::move(name.name), std::move(name.disambiguation)
 				));
@@ -56,28 +76,41 @@ namespace apigen {
 			[[nodiscard]] inline static cached_name register_name_prefix(
 				name_allocator &alloc, std::string_view prefix, naming_convention::name_info name
 			) {
+				if (name.lazy_disambiguation) {
+					return cached_name(alloc.allocate_variable_prefix(
+						prefix, std::move(name.name), std::move(name.lazy_disambiguation)
+					));
+				}
 				return cached_name(alloc.allocate_variable_prefix(
 					prefix, std::move(name.name), std::move(name.disambiguation)
 				));
 			}
 		protected:
-			std::variant<std::string, name_allocator::token> _data; ///< The data of this name.
+			/// The token. This is kept alive after the name is frozen since the \ref name_allocator still refers to
+			/// it.
+			name_allocator::token _token;
+			std::string _cached; ///< The cached name.
+			bool _frozen = false; ///< Whether this name has been frozen.
 		};
 
 		struct function_naming {
 			cached_name
 				api_name, ///< The name of the exported function pointer.
-				impl_name; ///< The name of the function that is the internal implementation.
+				impl_name, ///< The name of the function that is the internal implementation.
+				batch_api_name, ///< The name of the batch variant. Only valid if \ref batch is \p true.
+				batch_impl_name; ///< The name of the internal implementation of the batch variant.
+			bool batch = false; ///< Whether the batch variant of this function is exported.
 
 			/// Constructs a \ref function_naming from the given \ref entities::field_entity.
 			inline static function_naming from_entity(
 				entities::function_entity &ent, naming_convention &conv,
-				name_allocator &global_scope, name_allocator &impl_scope
+				name_allocator &global_scope, name_allocator &impl_scope, exporter &ex
 			) {
 				function_naming result;
+				auto *decl = ent.get_declaration();
 				auto name = conv.get_function_name_dynamic(ent);
-				result.impl_name = cached_name::register_name_prefix(impl_scope, "internal_", name);
-				result.api_name = cached_name::register_name(global_scope, std::move(name));
+				result.impl_name = ex._register_name(impl_scope, decl, _role_impl, name, "internal_");
+				result.api_name = ex._register_name(global_scope, decl, _role_api, std::move(name));
 				return result;
 			}
 		};
@@ -87,22 +120,53 @@ namespace apigen {
 				getter_api_name, ///< The exported name of the getter.
 				getter_impl_name, ///< The name of the getter's internal implementation.
 				const_getter_api_name, ///< The exported name of the const getter.
-				const_getter_impl_name; ///< The name of the const getter's internal implementation.
+				const_getter_impl_name, ///< The name of the const getter's internal implementation.
+				copy_out_api_name, ///< The exported name of the function that copies an array field out.
+				copy_out_impl_name, ///< The name of the internal implementation of the copy-out function.
+				copy_in_api_name, ///< The exported name of the function that copies an array field in.
+				copy_in_impl_name, ///< The name of the internal implementation of the copy-in function.
+				inline_getter_name, ///< The name of the inline getter in the API header.
+				inline_const_getter_name; ///< The name of the inline const getter in the API header.
+			/// The offset of the field in bytes if it's accessed using inline functions in the API header.
+			std::optional<std::uint64_t> offset;
 
 			/// Constructs a \ref field_naming from the given \ref entities::field_entity.
 			inline static field_naming from_entity(
 				entities::field_entity &ent, naming_convention &conv,
-				name_allocator &api_table_scope, name_allocator &impl_scope
+				name_allocator &api_table_scope, name_allocator &impl_scope, exporter &ex
 			) {
 				field_naming result;
+				auto *decl = ent.get_declaration();
 				if (ent.get_field_kind() == entities::field_kind::normal_field) {
 					auto name = conv.get_field_getter_name(ent);
-					result.getter_impl_name = cached_name::register_name_prefix(impl_scope, "internal_", name);
-					result.getter_api_name = cached_name::register_name(api_table_scope, std::move(name));
+					result.getter_impl_name = ex._register_name(impl_scope, decl, _role_getter_impl, name, "internal_");
+					result.getter_api_name = ex._register_name(api_table_scope, decl, _role_getter, std::move(name));
 				}
 				auto name = conv.get_field_const_getter_name(ent);
-				result.const_getter_impl_name = cached_name::register_name_prefix(impl_scope, "internal_", name);
-				result.const_getter_api_name = cached_name::register_name(api_table_scope, std::move(name));
+				result.const_getter_impl_name = ex._register_name(
+					impl_scope, decl, _role_const_getter_impl, name, "internal_"
+				);
+				result.const_getter_api_name = ex._register_name(
+					api_table_scope, decl, _role_const_getter, std::move(name)
+				);
+				if (_is_typed_array(ent.get_type())) {
+					auto copy_out_name = conv.get_field_copy_out_name(ent);
+					result.copy_out_impl_name = ex._register_name(
+						impl_scope, decl, _role_copy_out_impl, copy_out_name, "internal_"
+					);
+					result.copy_out_api_name = ex._register_name(
+						api_table_scope, decl, _role_copy_out, std::move(copy_out_name)
+					);
+					if (ent.get_field_kind() == entities::field_kind::normal_field) {
+						auto copy_in_name = conv.get_field_copy_in_name(ent);
+						result.copy_in_impl_name = ex._register_name(
+							impl_scope, decl, _role_copy_in_impl, copy_in_name, "internal_"
+						);
+						result.copy_in_api_name = ex._register_name(
+							api_table_scope, decl, _role_copy_in, std::move(copy_in_name)
+						);
+					}
+				}
 				return result;
 			}
 		};
@@ -113,14 +177,18 @@ namespace apigen {
 
 			/// Constructs a \ref enum_naming from the given \ref entities::enum_entity.
 			inline static enum_naming from_entity(
-				entities::enum_entity &ent, naming_convention &conv, name_allocator &global_scope
+				entities::enum_entity &ent, naming_convention &conv, name_allocator &global_scope, exporter &ex
 			) {
 				enum_naming result;
-				result.name = cached_name::register_name(global_scope, conv.get_enum_name(ent));
+				result.name = ex._register_name(
+					global_scope, ent.get_declaration(), _role_type, conv.get_enum_name(ent)
+				);
 				for (clang::EnumConstantDecl *enumerator : ent.get_declaration()->enumerators()) {
 					result.enumerators.emplace_back(
 						enumerator->getInitVal().getExtValue(),
-						cached_name::register_name(global_scope, conv.get_enumerator_name(ent, enumerator))
+						ex._register_name(
+							global_scope, enumerator, _role_enumerator, conv.get_enumerator_name(ent, enumerator)
+						)
 					);
 				}
 				return result;
@@ -131,18 +199,47 @@ namespace apigen {
 			cached_name
 				name, ///< The name of the exported record reference type.
 				destructor_api_name, ///< The exported name of the destructor.
-				destructor_impl_name; ///< The name of the internal implementation of the function.
+				destructor_impl_name, ///< The name of the internal implementation of the function.
+				/// The name of the size constant, which is in the API header if \ref size is not zero, and printed by
+				/// the data collection source otherwise.
+				size_name,
+				align_name, ///< The name of the alignment constant. Placed in the same way as \ref size_name.
+				storage_name, ///< The name of the storage struct. Only valid if \ref size is not zero.
+				snapshot_api_name, ///< The exported name of the snapshot function. Only valid if there's a view.
+				snapshot_impl_name, ///< The name of the implementation of the snapshot function.
+				apply_api_name, ///< The exported name of the apply function. Only valid if there's a writable field.
+				apply_impl_name, ///< The name of the implementation of the apply function.
+				view_name; ///< The name of the view struct. Only valid if \ref view_fields is not empty.
+			std::uint64_t
+				size = 0, ///< The size of the record, or zero if it's unknown or not exported.
+				alignment = 0; ///< The alignment of the record.
+			/// C declarations of the fields of the record in declaration order if it's passed by value, in which
+			/// case its layout is mirrored in the API header. Empty if the record is opaque.
+			std::vector<std::string> value_fields;
+			/// Fields that are copied into the view of the record, in declaration order. See \ref _is_view_field().
+			std::vector<entities::field_entity*> view_fields;
+			/// Names of the indices of the bits that select the corresponding elements of \ref view_fields for the
+			/// apply function. Bit \p i selects element \p i, and only writable fields have names; the entries of
+			/// other fields are empty.
+			std::vector<cached_name> view_bit_names;
+
+			/// Returns whether this record has an apply function, i.e., whether any field in its view is writable.
+			[[nodiscard]] bool has_apply_function() const {
+				return std::any_of(view_fields.begin(), view_fields.end(), _is_view_field_writable);
+			}
 
 			/// Constructs a \ref record_naming from the given \ref entities::record_entity.
 			inline static record_naming from_entity(
 				entities::record_entity &ent, naming_convention &conv,
-				name_allocator &global_scope, name_allocator &api_table_scope, name_allocator &impl_scope
+				name_allocator &global_scope, name_allocator &api_table_scope, name_allocator &impl_scope,
+				exporter &ex
 			) {
 				record_naming result;
-				result.name = cached_name::register_name(global_scope, conv.get_record_name(ent));
+				auto *decl = ent.get_declaration();
+				result.name = ex._register_name(global_scope, decl, _role_type, conv.get_record_name(ent));
 				auto name = conv.get_record_destructor_name(ent);
-				result.destructor_impl_name = cached_name::register_name_prefix(impl_scope, "internal_", name);
-				result.destructor_api_name = cached_name::register_name(api_table_scope, std::move(name));
+				result.destructor_impl_name = ex._register_name(impl_scope, decl, _role_dtor_impl, name, "internal_");
+				result.destructor_api_name = ex._register_name(api_table_scope, decl, _role_dtor, std::move(name));
 				return result;
 			}
 		};
@@ -152,30 +249,68 @@ namespace apigen {
 				api_name, ///< The API name of this function.
 				impl_name; ///< The name of this function's implementation.
 
-			/// Constructs a \ref custom_function_naming from the given \ref custom_function_entity.
-			inline static custom_function_naming from_entity(
-				custom_function_entity &ent, naming_convention &conv,
-				name_allocator &global_scope, name_allocator &impl_scope,
-				const exporter &ex
+			/// Constructs a \ref custom_function_naming from the suggested name of a \ref custom_function_entity.
+			inline static custom_function_naming from_suggested_name(
+				const naming_convention::name_info &name, name_allocator &global_scope, name_allocator &impl_scope
 			) {
 				custom_function_naming result;
-				auto name = ent.get_suggested_name(conv, ex);
 				result.api_name = cached_name::register_name(global_scope, name);
 				result.impl_name = cached_name::register_name_prefix(impl_scope, "internal_", name);
 				return result;
 			}
 		};
 
+		/// A subset of implementations in the host source files. Implementations are distributed among shards by
+		/// stable hashes of their names.
+		struct host_shard {
+			/// Default constructor. The default shard contains all implementations.
+			host_shard() = default;
+			/// Initializes all fields of this struct.
+			host_shard(std::size_t i, std::size_t c) : index(i), count(c) {
+			}
+
+			/// Returns whether the implementation with the given name belongs to this shard.
+			[[nodiscard]] bool contains(std::string_view key) const {
+				return count < 2 || stable_hash(key) % count == index;
+			}
+
+			std::size_t
+				index = 0, ///< The index of this shard.
+				count = 1; ///< The total number of shards.
+		};
+
+		/// Contains naming information of a group of API functions that's exported to a separate header.
+		struct api_group_naming {
+			cached_name
+				struct_name, ///< The name of the sub-table structure.
+				member_name; ///< The name of the sub-table in the API structure.
+		};
+		/// Contains naming information of a SIMD vector type used by exported functions or fields.
+		struct vector_type_naming {
+			cached_name name; ///< The name of the typedef of the vector type in the API header.
+			std::uint64_t size = 0; ///< The size of the vector type in bytes.
+		};
+		/// Contains naming information of a fixed-size array type used by exported fields.
+		struct array_type_naming {
+			cached_name name; ///< The name of the typedef of the array type in the API header.
+			std::string element; ///< The exported name of the element type.
+			std::vector<std::uint64_t> extents; ///< The extents of the array, starting from the outermost one.
+		};
+
 		/// Stores the naming of functions.
-		using function_name_mapping = std::unordered_map<entities::function_entity*, function_naming>;
+		using function_name_mapping = insertion_ordered_map<entities::function_entity*, function_naming>;
 		/// Stores the naming of enums.
-		using enum_name_mapping = std::unordered_map<entities::enum_entity*, enum_naming>;
+		using enum_name_mapping = insertion_ordered_map<entities::enum_entity*, enum_naming>;
 		/// Stores the naming of records.
-		using record_name_mapping = std::unordered_map<entities::record_entity*, record_naming>;
+		using record_name_mapping = insertion_ordered_map<entities::record_entity*, record_naming>;
 		/// Stores the naming of fields.
-		using field_name_mapping = std::unordered_map<entities::field_entity*, field_naming>;
+		using field_name_mapping = insertion_ordered_map<entities::field_entity*, field_naming>;
 		/// Stores the naming of custom functions.
-		using custom_function_name_mapping = std::unordered_map<custom_function_entity*, custom_function_naming>;
+		using custom_function_name_mapping = insertion_ordered_map<custom_function_entity*, custom_function_naming>;
+		/// Stores the naming of vector types, indexed by their canonical types.
+		using vector_type_name_mapping = insertion_ordered_map<const clang::VectorType*, vector_type_naming>;
+		/// Stores the naming of array types, indexed by \ref _get_array_type_key().
+		using array_type_name_mapping = insertion_ordered_map<std::string, array_type_naming>;
 
 		/// Initializes \ref internal_printing_policy.
 		exporter(clang::PrintingPolicy policy, const entity_registry &reg) :
@@ -192,94 +327,401 @@ namespace apigen {
 		/// Collects exported entities from the given \ref entity_registry.
 		void collect_exported_entities(entity_registry &reg) {
 			name_allocator api_table_scope = name_allocator::from_parent(_global_scope);
-			for (auto &&[_, ent_ptr] : reg.get_entities()) {
-				if (ent_ptr->is_marked_for_exporting()) {
-					entity *ent = ent_ptr.get();
-					if (auto *func_entity = dyn_cast<entities::function_entity>(ent)) {
-						_function_names.emplace(func_entity, function_naming::from_entity(
-							*func_entity, *naming, _global_scope, _impl_scope
-						));
-					} else if (auto *field_entity = dyn_cast<entities::field_entity>(ent)) {
-						_field_names.emplace(field_entity, field_naming::from_entity(
-							*field_entity, *naming, api_table_scope, _impl_scope
-						));
-					} else if (auto *enum_entity = dyn_cast<entities::enum_entity>(ent)) {
-						_enum_names.emplace(enum_entity, enum_naming::from_entity(
-							*enum_entity, *naming, _global_scope
-						));
-					} else if (auto *record_entity = dyn_cast<entities::record_entity>(ent)) {
-						_record_names.emplace(record_entity, record_naming::from_entity(
-							*record_entity, *naming, _global_scope, api_table_scope, _impl_scope
-						));
+			// names in the API header are subject to the length limit of the naming convention; implementation names
+			// are not
+			name_allocator::shortener shorten = [this](std::string name) {
+				return naming->shorten_name(std::move(name));
+			};
+			_global_scope.name_shortener = shorten;
+			api_table_scope.name_shortener = std::move(shorten);
+			if (slot_layout) {
+				// these members are always present, so they take precedence over all other names
+				_layout_member_names.emplace_back(_global_scope.allocate_fixed(std::string(api_size_member_name)));
+				_layout_member_names.emplace_back(_global_scope.allocate_fixed(std::string(api_version_member_name)));
+			}
+			if (ledger) {
+				_reserve_ledger_names(reg, api_table_scope);
+			}
+			std::vector<entity*> exported = _get_exported_entities_in_declaration_order(reg);
+			if (split_api_header) {
+				_collect_api_groups(exported);
+			}
+			// names are allocated in declaration order so that both the names and the order of the output are the
+			// same across runs
+			for (entity *ent : exported) {
+				if (auto *func_entity = dyn_cast<entities::function_entity>(ent)) {
+					_function_names.emplace(func_entity, function_naming::from_entity(
+						*func_entity, *naming, _global_scope, _impl_scope, *this
+					));
+				} else if (auto *field_entity = dyn_cast<entities::field_entity>(ent)) {
+					_field_names.emplace(field_entity, field_naming::from_entity(
+						*field_entity, *naming, api_table_scope, _impl_scope, *this
+					));
+				} else if (auto *enum_entity = dyn_cast<entities::enum_entity>(ent)) {
+					_enum_names.emplace(enum_entity, enum_naming::from_entity(
+						*enum_entity, *naming, _global_scope, *this
+					));
+				} else if (auto *record_entity = dyn_cast<entities::record_entity>(ent)) {
+					_record_names.emplace(record_entity, record_naming::from_entity(
+						*record_entity, *naming, _global_scope, api_table_scope, _impl_scope, *this
+					));
+				}
+			}
+			// whether records are passed by value decides which functions can have batch variants
+			if (by_value_record_size > 0) {
+				for (auto &[ent, name] : _record_names) {
+					name.value_fields = _get_value_fields(
+						ent->get_declaration(), by_value_record_size, printing_policy
+					);
+				}
+			}
+			for (auto &[ent, name] : _function_names) {
+				_register_batch_function(ent, name);
+			}
+			if (record_views) {
+				// views of recursively exported records contain all their eligible fields
+				for (auto &[ent, name] : _field_names) {
+					auto parent_it = _record_names.find(ent->get_parent());
+					if (parent_it != _record_names.end() && parent_it->first->is_recursive() && _is_view_field(ent)) {
+						parent_it->second.view_fields.emplace_back(ent);
 					}
 				}
+				for (auto &[ent, name] : _record_names) {
+					_register_record_view(ent, name, api_table_scope);
+				}
 			}
 			// freeze all non-custom entity names so that they can be used by custom function entities
 			for (auto &[ent, name] : _function_names) {
-				name.api_name.freeze();
-				name.impl_name.freeze();
+				_freeze(name.api_name);
+				_freeze(name.impl_name);
+				_freeze(name.batch_api_name);
+				_freeze(name.batch_impl_name);
 			}
 			for (auto &[ent, name] : _enum_names) {
-				name.name.freeze();
+				_freeze(name.name);
 				for (auto &[val, enum_name] : name.enumerators) {
-					enum_name.freeze();
+					_freeze(enum_name);
 				}
 			}
 			for (auto &[ent, name] : _record_names) {
-				name.name.freeze();
-				name.destructor_api_name.freeze();
-				name.destructor_impl_name.freeze();
+				_freeze(name.name);
+				_freeze(name.destructor_api_name);
+				_freeze(name.destructor_impl_name);
+				_freeze(name.snapshot_api_name);
+				_freeze(name.snapshot_impl_name);
+				_freeze(name.apply_api_name);
+				_freeze(name.apply_impl_name);
 			}
 			for (auto &[ent, name] : _field_names) {
-				name.getter_impl_name.freeze();
-				name.getter_api_name.freeze();
-				name.const_getter_impl_name.freeze();
-				name.const_getter_api_name.freeze();
+				_freeze(name.getter_impl_name);
+				_freeze(name.getter_api_name);
+				_freeze(name.const_getter_impl_name);
+				_freeze(name.const_getter_api_name);
+				_freeze(name.copy_out_impl_name);
+				_freeze(name.copy_out_api_name);
+				_freeze(name.copy_in_impl_name);
+				_freeze(name.copy_in_api_name);
 			}
 
-			// generate names for custom function entities
+			// generate names for custom function entities; these are registered in an order that depends on
+			// dependency analysis, so they're sorted by their suggested names instead
+			std::vector<std::pair<custom_function_entity*, naming_convention::name_info>> custom_funcs;
 			for (auto &ent : reg.get_custom_functions()) {
-				_custom_func_names.emplace(ent.get(), custom_function_naming::from_entity(
-					*ent, *naming, _global_scope, _impl_scope, *this
+				custom_funcs.emplace_back(ent.get(), ent->get_suggested_name(*naming, *this));
+			}
+			std::stable_sort(custom_funcs.begin(), custom_funcs.end(), [](const auto &lhs, const auto &rhs) {
+				return
+					std::tie(lhs.second.name, lhs.second.disambiguation) <
+					std::tie(rhs.second.name, rhs.second.disambiguation);
+			});
+			for (auto &&[ent, name] : custom_funcs) {
+				_custom_func_names.emplace(ent, custom_function_naming::from_suggested_name(
+					name, _global_scope, _impl_scope
 				));
 			}
 
 			// freeze names for custom function names
 			for (auto &[ent, name] : _custom_func_names) {
-				name.api_name.freeze();
-				name.impl_name.freeze();
+				_freeze(name.api_name);
+				_freeze(name.impl_name);
+			}
+			for (auto &[group, name] : _api_groups) {
+				_freeze(name.struct_name);
+				_freeze(name.member_name);
+			}
+
+			// record the final names
+			if (ledger) {
+				for (auto &&[key, info] : _ledger_names) {
+					ledger->record(key, info->get_name());
+				}
+				// reservations that have not been claimed belong to roles that are no longer generated, e.g., view
+				// functions after record_views is turned off; they're not recorded, so their names are free again in
+				// the next run
+				for (auto &&[key, token] : _reserved_names) {
+					logger::get().log(
+						log_category::naming, log_level::info,
+						"name ledger entry {} ({}) is no longer used and is dropped", key, token->get_name()
+					);
+				}
+			}
+			if (slot_layout) {
+				slot_layout->update(_get_api_table_slot_names(""));
+			}
+
+			// names of vector types, record layouts, and direct-link functions are allocated last so that they never
+			// affect other names
+			for (auto &[ent, name] : _function_names) {
+				clang::ASTContext &context = ent->get_declaration()->getASTContext();
+				if (auto &return_type = ent->get_api_return_type()) {
+					_register_vector_type(return_type->type, context);
+				}
+				for (auto &&param : ent->get_parameters()) {
+					_register_vector_type(param.type.type, context);
+				}
+			}
+			for (auto &[ent, name] : _field_names) {
+				_register_vector_type(ent->get_type().type, ent->get_declaration()->getASTContext());
+			}
+			// array types may have vector elements
+			for (auto &[ent, name] : _field_names) {
+				if (_is_typed_array(ent->get_type())) {
+					_register_array_type(ent->get_type());
+				}
+			}
+			if (inline_field_access) {
+				for (auto &[ent, name] : _field_names) {
+					if (ent->get_field_kind() == entities::field_kind::reference_field) {
+						continue;
+					}
+					name.offset = get_field_offset(ent->get_declaration());
+					if (!name.offset) {
+						continue;
+					}
+					if (ent->get_field_kind() == entities::field_kind::normal_field) {
+						name.inline_getter_name = cached_name(_global_scope.allocate_variable_custom(
+							fmt::format(naming->inline_accessor_name_pattern, name.getter_api_name.get_cached()),
+							"_inline"
+						));
+						_freeze(name.inline_getter_name);
+					}
+					name.inline_const_getter_name = cached_name(_global_scope.allocate_variable_custom(
+						fmt::format(naming->inline_accessor_name_pattern, name.const_getter_api_name.get_cached()),
+						"_inline"
+					));
+					_freeze(name.inline_const_getter_name);
+				}
+			}
+			// size and alignment constants are named for all records, since the data collection source prints them
+			// for records whose layouts are not in the API header
+			for (auto &[ent, name] : _record_names) {
+				std::string_view rec_name = name.name.get_cached();
+				name.size_name = cached_name(_global_scope.allocate_variable_custom(
+					fmt::format(naming->size_name_pattern, rec_name), "_layout"
+				));
+				name.align_name = cached_name(_global_scope.allocate_variable_custom(
+					fmt::format(naming->align_name_pattern, rec_name), "_layout"
+				));
+				if (!export_record_layouts) {
+					continue;
+				}
+				if (auto layout = get_record_layout(ent->get_declaration())) {
+					std::tie(name.size, name.alignment) = layout.value();
+					name.storage_name = cached_name(_global_scope.allocate_variable_custom(
+						fmt::format(naming->storage_name_pattern, rec_name), "_layout"
+					));
+				}
+			}
+			for (auto &[ent, name] : _record_names) {
+				_freeze(name.size_name);
+				_freeze(name.align_name);
+				_freeze(name.storage_name);
+			}
+			if (record_views) {
+				for (auto &[ent, name] : _record_names) {
+					if (name.view_fields.empty()) {
+						continue;
+					}
+					name.view_name = cached_name(_global_scope.allocate_variable_custom(
+						fmt::format(naming->view_name_pattern, name.name.get_cached()), "_view"
+					));
+					_freeze(name.view_name);
+					for (entities::field_entity *field : name.view_fields) {
+						if (!_is_view_field_writable(field)) {
+							name.view_bit_names.emplace_back();
+							continue;
+						}
+						cached_name &bit_name = name.view_bit_names.emplace_back(
+							_global_scope.allocate_variable_custom(fmt::format(
+								naming->view_bit_name_pattern,
+								name.view_name.get_cached(), to_string_view(field->get_declaration()->getName())
+							), "_bit")
+						);
+						_freeze(bit_name);
+					}
+				}
+			}
+			if (direct_link) {
+				std::string prefix = std::string(naming->api_struct_name) + "_";
+				for (const _direct_function &func : _get_direct_functions()) {
+					cached_name &name = _direct_names.try_emplace(func.api_name).first->second;
+					name = cached_name(_global_scope.allocate_variable_prefix(
+						prefix, std::string(func.api_name), std::string()
+					));
+					_freeze(name);
+				}
 			}
 		}
 
 	protected:
+		/// Exports code for each element of the given mapping that satisfies the given predicate, separated by empty
+		/// lines. The code is generated using the given function, concurrently if \ref num_threads is larger than 1,
+		/// and written in the order of the mapping.
+		template <typename Mapping, typename Func, typename Pred> void _export_fragments(
+			cpp_writer&, const Mapping&, const Func&, const Pred&
+		) const;
+
+		/// The C signature of an API function pointer that's also exported as a direct-link function.
+		struct _direct_function {
+			std::string_view
+				api_name, ///< The name of the function pointer in the API structure.
+				impl_name, ///< The name of the implementation.
+				shard_key, ///< The key used to decide which \ref host_shard the implementation belongs to.
+				group; ///< The API group.
+			std::string return_type; ///< The return type, including trailing asterisks or a space.
+			std::vector<std::string> parameter_types; ///< Types of all parameters.
+
+			/// Returns the given type followed by the given name, separated by a space if necessary.
+			[[nodiscard]] static std::string get_declaration(std::string_view type, std::string_view name) {
+				std::string result(type);
+				if (!result.empty() && result.back() != ' ' && result.back() != '*') {
+					result += ' ';
+				}
+				result += name;
+				return result;
+			}
+		};
+		/// Returns all API functions that are also exported as direct-link functions, i.e., all except custom
+		/// functions whose signatures are opaque.
+		[[nodiscard]] std::vector<_direct_function> _get_direct_functions() const;
+		/// Exports declarations of the direct-link functions of the given group inside an <cc>extern "C"</cc> block.
+		void _export_api_direct_declarations(cpp_writer&, std::string_view group) const;
+
+		/// Exports the macros used by the API headers.
+		void _export_api_macros(cpp_writer&) const;
+		/// Exports API macros, enums, and record declarations.
+		void _export_api_type_declarations(cpp_writer&) const;
+		/// Exports API macros and the types that may be used by value in any group: vector and array types, the
+		/// integer types of enums, and record declarations, which are only complete for records mirrored by value.
+		void _export_api_forward_declarations(cpp_writer&) const;
+		/// Exports definitions that belong to the given group: enumerators, record layouts, views, and inline field
+		/// accessors. These only depend on the types exported by \ref _export_api_forward_declarations().
+		void _export_api_group_definitions(cpp_writer&, std::string_view group) const;
+		/// Exports a structure that contains all API function pointers of the given group. For the root group (an
+		/// empty string), sub-tables of all other groups are also included.
+		void _export_api_table(cpp_writer&, std::string_view struct_name, std::string_view group) const;
+
 		/// Exports an API enum type.
 		void _export_api_enum_type(cpp_writer&, entities::enum_entity*, const enum_naming&) const;
-		/// Exports an API type.
+		/// Exports the enumerators of an API enum type as an anonymous enum.
+		static void _export_api_enumerators(cpp_writer&, const enum_naming&);
+		/// Exports the typedef of the integer type used by an API enum type.
+		void _export_api_enum_typedef(cpp_writer&, entities::enum_entity*, const enum_naming&) const;
+		/// Exports the typedef of a vector type. Vectors declared with \p ext_vector_type fall back to an equally large
+		/// \p vector_size vector for compilers other than clang.
+		static void _export_api_vector_type(cpp_writer&, const clang::VectorType*, const vector_type_naming&);
+		/// Exports inline functions that access the given field by adding its offset to the object pointer. They're
+		/// declared with \p APIGEN_INLINE, which is \p inline in C++ so that they can be exported from modules, and
+		/// <cc>static inline</cc> in C.
+		void _export_api_inline_field_accessors(cpp_writer&, entities::field_entity*, const field_naming&) const;
+		/// Exports the typedef of an array type.
+		static void _export_api_array_type(cpp_writer&, const array_type_naming&);
+		/// Exports an API type. If its layout is known, its size and alignment constants and its storage struct are
+		/// also exported.
 		static void _export_api_type(cpp_writer&, const record_naming&);
+		/// Exports the typedef of an API type, which also defines its fields if it's mirrored by value.
+		static void _export_api_record_declaration(cpp_writer&, const record_naming&);
+		/// Exports the size and alignment constants and the storage struct of an API type whose layout is known.
+		static void _export_api_record_layout(cpp_writer&, const record_naming&);
 		/// Exports the definition of an API function pointer.
 		void _export_api_function_pointer_definition(
 			cpp_writer&, entities::function_entity*, const function_naming&
 		) const;
+		/// Exports the definition of the API function pointer of the batch variant of a function.
+		void _export_api_batch_function_pointer_definition(
+			cpp_writer&, entities::function_entity*, const function_naming&
+		) const;
 		/// Exports the definition of an API class destructor.
 		void _export_api_destructor_definition(cpp_writer&, entities::record_entity*, const record_naming&) const;
+		/// Exports the definition of either the snapshot or the apply function of a record that has a view.
+		void _export_api_record_view_function_definition(cpp_writer&, const record_naming&, bool apply) const;
+		/// Exports the view struct of a record, followed by the indices of the bits of its fields in masks.
+		void _export_api_record_view(cpp_writer&, const record_naming&) const;
+		/// Exports the type of a field in a view struct, which is the type of the field without top-level
+		/// qualifiers.
+		void _export_api_view_field_type(cpp_writer&, const entities::field_entity*) const;
 		/// Exports the definition of API field getters.
 		void _export_api_field_getter_definitions(cpp_writer&, entities::field_entity*, const field_naming&) const;
+		/// Exports the definition of either the non-const or the const getter of a field.
+		void _export_api_field_getter_definition(
+			cpp_writer&, entities::field_entity*, const field_naming&, bool is_const
+		) const;
+		/// Exports the definition of the function that copies an array field out of or into an object.
+		void _export_api_field_copy_definition(
+			cpp_writer&, entities::field_entity*, const field_naming&, bool copy_in
+		) const;
+		/// Exports the return type of a field getter, including the name of the type. Fields whose types are arrays
+		/// exported by \ref _is_typed_array() are returned as pointers to their array typedefs.
+		void _export_api_field_getter_return_type(cpp_writer&, entities::field_entity*, bool is_const) const;
+		/// Exports the members of the API structure in the order given by \ref slot_layout, preceded by its size and
+		/// version.
+		void _export_stable_api_table_members(cpp_writer&) const;
+		/// Returns the names of the members of the API table of the given group in their default order. Sub-tables
+		/// are not included.
+		[[nodiscard]] std::vector<std::string_view> _get_api_table_slot_names(std::string_view group) const;
+		/// Returns the C declarations of the fields of the given record if it can be passed by value, i.e., if it's
+		/// a trivially copyable standard-layout struct no larger than the given size whose fields are all public and
+		/// only involve builtin types, pointers to them, and arrays of them, and whose layout is the same as that of
+		/// a C struct with these fields, i.e., it's not affected by alignment or packing attributes. Returns an empty
+		/// list otherwise.
+		[[nodiscard]] static std::vector<std::string> _get_value_fields(
+			const clang::CXXRecordDecl*, std::uint64_t max_size, const clang::PrintingPolicy&
+		);
 	public:
 		/// Returns the name of a type used in the API header. The \ref entity will be used only if the type is not a
 		/// built-in type.
 		[[nodiscard]] std::string_view get_exported_type_name(const clang::Type*, entity*) const;
+		/// Returns whether the given type is a record type that's passed and returned by value in the API. See
+		/// \ref by_value_record_size.
+		[[nodiscard]] bool is_passed_by_value(const qualified_type&) const;
 		/// Exports a type as a return type in the API.
 		void export_api_return_type(cpp_writer&, const qualified_type&) const;
 		/// Exports a type as a parameter in the API header. Reference types will be exported as pointer types, and
-		/// primitive types such as built-in types and enums are exported as-is. If a record type has a move
-		/// constructor, it will be implicitly moved; otherwise it will be copied.
+		/// primitive types such as built-in types and enums are exported as-is. Records that are passed by value are
+		/// also exported as-is. For other records, if a record type has a move constructor, it will be implicitly
+		/// moved; otherwise it will be copied.
 		void export_api_parameter_type(cpp_writer&, const qualified_type&, bool mark_move) const;
 		/// Exports asterisks and qualifiers for an exported type, converting references to corresponding pointers.
 		static void export_api_pointers_and_qualifiers(
 			cpp_writer &writer, reference_kind ref, const std::vector<qualifier> &quals
 		);
-		/// Exports the API header.
+		/// Exports the API header. If \ref split_api_header is \p true, this header only contains the API structure
+		/// and the definitions of the root group, and the user has to manually add <cc>#include</cc> directives of
+		/// the forward declaration header and all group headers.
 		void export_api_header(std::ostream&) const;
+		/// Exports the header that declares all exported types, but not enumerators, layouts, views, or accessors.
+		/// This is only used when \ref split_api_header is \p true.
+		void export_api_forward_header(std::ostream&) const;
+		/// Exports the header that contains the sub-table of the given group, along with the enumerators, layouts,
+		/// views, and inline accessors of the types in the group. This is only used when \ref split_api_header is
+		/// \p true. The user has to manually add an <cc>#include</cc> directive of the forward declaration header.
+		void export_api_group_header(std::ostream&, std::string_view group) const;
+		/// Exports a C++20 module interface unit with the given name that exports everything declared in the API
+		/// header, including the functions declared with \ref direct_link. The header is included with the given
+		/// path inside an exported <cc>extern "C++"</cc> block, which keeps the declarations attached to the global
+		/// module and compatible with C clients. Exporting using-declarations of names from a global module
+		/// fragment instead does not make typedef names visible to importers with GCC 12.
+		void export_api_module(std::ostream&, std::string_view module_name, std::string_view api_header_include) const;
 
 		/// Exports the host header.
 		void export_host_h(std::ostream&) const;
@@ -299,21 +741,119 @@ namespace apigen {
 		void _export_plain_function_call(
 			cpp_writer&, entities::function_entity*, const std::vector<std::string>&
 		) const;
-		/// Exports the implementation of the given function.
+		/// Returns whether the signature of the given function is identical to that of its API function pointer, so
+		/// that the address of the function itself can be stored in the API structure. This is the case for free and
+		/// static member functions with the default calling convention, whose return type and parameters are all
+		/// builtin types or pointers to them.
+		[[nodiscard]] static bool _can_elide_wrapper(entities::function_entity*);
+		/// Exports the implementation of the given function. If \ref elide_wrappers is \p true and
+		/// \ref _can_elide_wrapper() returns \p true, the implementation is a constant pointer to the function
+		/// instead of a wrapper.
 		void _export_function_impl(cpp_writer&, entities::function_entity*, const function_naming&) const;
-		/// Exports the implementations of field getters.
+		/// Exports the implementation of the batch variant of a function, which calls the implementation of the
+		/// function for each element of the argument arrays so that the call can be inlined.
+		void _export_batch_function_impl(cpp_writer&, entities::function_entity*, const function_naming&) const;
+		/// Exports the implementations of field getters, and of copy functions for array fields.
 		void _export_field_getter_impls(cpp_writer&, entities::field_entity*, const field_naming&) const;
 		/// Exports the destructor implementation.
 		void _export_destructor_impl(cpp_writer&, entities::record_entity*, const record_naming&) const;
+		/// Exports the implementations of the snapshot and the apply functions of a record if it has a view.
+		void _export_record_view_impls(cpp_writer&, entities::record_entity*, const record_naming&) const;
+		/// Returns the name that's used to decide which \ref host_shard the implementations belong to.
+		[[nodiscard]] static std::string_view _get_host_shard_key(const function_naming &name) {
+			return name.impl_name.get_cached();
+		}
+		/// \overload
+		[[nodiscard]] static std::string_view _get_host_shard_key(const record_naming &name) {
+			return name.destructor_impl_name.get_cached();
+		}
+		/// \overload
+		[[nodiscard]] static std::string_view _get_host_shard_key(const field_naming &name) {
+			return name.const_getter_impl_name.get_cached();
+		}
+		/// \overload
+		[[nodiscard]] static std::string_view _get_host_shard_key(const custom_function_naming &name) {
+			return name.impl_name.get_cached();
+		}
+
+		/// Exports static assertions that check the sizes and alignments of records against the constants and the
+		/// mirrored structs in the API header, in case the host is compiled for a different target than the one
+		/// apigen parsed the code for.
+		void _export_host_record_layout_checks(cpp_writer&) const;
+		/// Exports <cc>#include</cc> directives of custom host-side dependencies.
+		void _export_host_custom_dependencies(cpp_writer&) const;
+		/// Exports the function template that converts records passed by value to and from their mirrored API
+		/// structs, if there are any such records. The bytes are copied with \p std::memcpy since the two structs are
+		/// unrelated types, and accessing one through a pointer to the other would violate strict aliasing.
+		void _export_host_value_conversion(cpp_writer&) const;
+		/// Exports a class with the given name that contains the implementations in the given \ref host_shard.
+		void _export_host_impls(cpp_writer&, std::string_view class_name, host_shard) const;
+		/// Exports the definitions of all direct-link functions whose implementations are in the given shard. These
+		/// functions forward to the implementations, which are members of the given class.
+		void _export_host_direct_functions(cpp_writer&, std::string_view class_name, host_shard) const;
+		/// Exports statements that initialize the size, the version, and the tombstones of the API structure when
+		/// \ref slot_layout is used.
+		void _export_host_layout_init(cpp_writer&, std::string_view result_var) const;
+		/// Exports a function with the given name that fills the API structure with the implementations in the given
+		/// \ref host_shard, which are members of the given class. The first shard also initializes the members
+		/// exported by \ref _export_host_layout_init().
+		void _export_host_api_init(
+			cpp_writer&, std::string_view func_name, std::string_view class_name, host_shard
+		) const;
 	public:
 		/// Exports the host CPP file that holds the implementation of all API functions. The user has to manually add
 		/// <cc>#include</cc> directives of the host header and the API header.
 		void export_host_cpp(std::ostream&) const;
+		/// Exports one of the host CPP files that hold the implementations when they're split into multiple shards.
+		/// The shard also defines a function that fills in its part of the API structure. The user has to manually
+		/// add <cc>#include</cc> directives of the host header and the API header.
+		void export_host_cpp_shard(std::ostream&, host_shard) const;
+		/// Exports the host CPP file that defines the API initialization function when the implementations are split
+		/// into the given number of shards. The user has to manually add <cc>#include</cc> directives of the host
+		/// header and the API header.
+		void export_host_cpp_shard_init(std::ostream&, std::size_t count) const;
+
+		/// Returns the name of the nested class of \p APIGEN_API_CLASS_NAME that holds the implementations of the
+		/// shard with the given index.
+		[[nodiscard]] static std::string get_host_shard_class_name(std::size_t index) {
+			return fmt::format("shard_{}", index);
+		}
+		/// Returns the name of the function that fills the API structure with the implementations of the shard with
+		/// the given index.
+		[[nodiscard]] static std::string get_host_shard_init_function_name(std::size_t index) {
+			return fmt::format("_apigen_priv_init_shard_{}", index);
+		}
+
+		/// Returns the name of the type alias in the host implementation class that refers to the record with the
+		/// given index in the field offset checks. The alias is necessary since \p offsetof is a macro, so template
+		/// arguments that contain commas cannot be passed to it directly.
+		[[nodiscard]] static std::string get_host_layout_alias_name(std::size_t index) {
+			return fmt::format("_apigen_priv_layout_{}", index);
+		}
+
+		/// Returns the name of the member of the API structure that occupies the removed slot with the given index.
+		[[nodiscard]] static std::string get_tombstone_name(std::size_t index) {
+			return fmt::format("_apigen_tombstone_{}", index);
+		}
+
+		/// Returns the size and alignment of the given record in bytes, or \p std::nullopt if they're unknown, e.g.,
+		/// for incomplete or dependent types.
+		[[nodiscard]] static std::optional<std::pair<std::uint64_t, std::uint64_t>> get_record_layout(
+			const clang::CXXRecordDecl*
+		);
+		/// Returns the offset of the given field in bytes if its parent is a standard-layout record whose layout is
+		/// known and the field is not a bit-field, or \p std::nullopt otherwise.
+		[[nodiscard]] static std::optional<std::uint64_t> get_field_offset(const clang::FieldDecl*);
 
 		/// Exports a \p cpp file that collects the sizes and alignments of data structures when ran. The user needs to
 		/// manually add <cc>#include</cc> directives to the fromt of the output file.
 		void export_data_collection_cpp(std::ostream&) const;
 
+		/// Builds an \ref api_manifest that describes all API tables in the order their members are declared, and
+		/// all exported records and enums. Sizes and alignments of records are those of the target that the source
+		/// code is parsed for.
+		[[nodiscard]] api_manifest build_manifest() const;
+
 		/// Returns \ref _impl_scope.
 		[[nodiscard]] const name_allocator &get_implmentation_scope() const {
 			return _impl_scope;
@@ -335,20 +875,213 @@ namespace apigen {
 		[[nodiscard]] const field_name_mapping &get_field_names() const {
 			return _field_names;
 		}
+		/// Returns \ref _api_groups.
+		[[nodiscard]] const std::map<std::string, api_group_naming, std::less<>> &get_api_groups() const {
+			return _api_groups;
+		}
 		/// Returns \ref _custom_func_names.
 		[[nodiscard]] const custom_function_name_mapping &get_custom_function_names() const {
 			return _custom_func_names;
 		}
+		/// Returns \ref _shortened_names.
+		[[nodiscard]] const std::map<std::string, std::string> &get_shortened_names() const {
+			return _shortened_names;
+		}
 
 		clang::PrintingPolicy printing_policy; ///< Printing policy for builtin types.
 		naming_convention *naming = nullptr; ///< The naming convention of exported types and functions.
+		/// If this is not \p nullptr, names assigned in previous runs are reused for entities that still exist, and
+		/// all assigned names are recorded in it.
+		name_ledger *ledger = nullptr;
+		/// The number of threads used to generate code for individual entities. Values smaller than 2 disable
+		/// multithreading. This limit is shared by all export functions that run concurrently, e.g., for different
+		/// output files.
+		std::size_t num_threads = 1;
+		/// If \p true, function pointers of entities in each top-level namespace are put in a separate sub-table with
+		/// its own header. This must be set before calling \ref collect_exported_entities().
+		bool split_api_header = false;
+		/// If this is not \p nullptr, the members of the API structure are laid out in the order recorded in it, new
+		/// members are appended, and members of removed entities are kept as tombstones. The structure then begins
+		/// with its size and the version of the layout. This is updated by \ref collect_exported_entities(), and
+		/// cannot be used together with \ref split_api_header.
+		slot_ledger *slot_layout = nullptr;
+		/// If \p true, every API function except custom functions is also declared in the API header as an
+		/// <cc>extern "C"</cc> function that's defined in the host source files, so that statically linked clients
+		/// can call it directly and have it inlined with LTO. The function pointer table is still exported. This must
+		/// be set before calling \ref collect_exported_entities().
+		bool direct_link = false;
+		/// If \p true, functions whose signatures are identical to those of their API function pointers are stored
+		/// in the API structure directly instead of through wrappers. See \ref _can_elide_wrapper().
+		bool elide_wrappers = true;
+		/// If \p true, the API header defines size and alignment constants and an aligned storage struct for each
+		/// record whose layout is known, so that clients can construct objects without allocating memory on the
+		/// heap. This must be set before calling \ref collect_exported_entities().
+		bool export_record_layouts = true;
+		/// Trivially copyable standard-layout records no larger than this number of bytes have their layout mirrored
+		/// in the API header and are passed and returned by value, so that the native ABI can pass them in
+		/// registers. Zero, the default, disables this; enabling it changes the signatures of functions that use
+		/// such records. See \ref _get_value_fields(). This must be set before calling
+		/// \ref collect_exported_entities().
+		std::uint64_t by_value_record_size = 0;
+		/// If \p true, the API header contains inline getters for fields of standard-layout records that add the
+		/// offsets of the fields to the object pointers, so that they can be accessed without calling through the
+		/// API structure. This must be set before calling \ref collect_exported_entities().
+		bool inline_field_access = true;
+		/// If \p true, each record whose members are all exported gets a view struct in the API header that holds
+		/// copies of its scalar, enum, vector, and pointer fields, together with a snapshot function that fills the
+		/// view and an apply function that writes the fields selected by a mask back, so that clients can access
+		/// many fields with a single call. This must be set before calling \ref collect_exported_entities().
+		bool record_views = true;
+
+		/// The name of the member of the API structure that holds its size when \ref slot_layout is used. Clients
+		/// can compare it against the offset of a member to check whether the host provides it.
+		constexpr static std::string_view api_size_member_name = "api_size";
+		/// The name of the member of the API structure that holds \ref slot_ledger::get_version() when
+		/// \ref slot_layout is used.
+		constexpr static std::string_view api_version_member_name = "api_version";
 	protected:
+		/// The name of the function template in host sources that copies records to and from their mirrored structs.
+		constexpr static std::string_view _value_conversion_name = "_apigen_priv_bit_cast";
+
+		// roles of names in the ledger
+		constexpr static std::string_view
+			_role_api = "api", ///< The API function pointer of a function.
+			_role_impl = "impl", ///< The implementation of a function.
+			_role_batch = "batch", ///< The API function pointer of the batch variant of a function.
+			_role_batch_impl = "batch_impl", ///< The implementation of the batch variant of a function.
+			_role_type = "type", ///< An enum or record type.
+			_role_enumerator = "enumerator", ///< An enumerator.
+			_role_dtor = "dtor", ///< The API function pointer of a destructor.
+			_role_dtor_impl = "dtor_impl", ///< The implementation of a destructor.
+			_role_getter = "getter", ///< The API function pointer of a field getter.
+			_role_getter_impl = "getter_impl", ///< The implementation of a field getter.
+			_role_const_getter = "const_getter", ///< The API function pointer of a const field getter.
+			_role_const_getter_impl = "const_getter_impl", ///< The implementation of a const field getter.
+			_role_copy_out = "copy_out", ///< The API function pointer that copies an array field out.
+			_role_copy_out_impl = "copy_out_impl", ///< The implementation of a copy-out function.
+			_role_copy_in = "copy_in", ///< The API function pointer that copies an array field in.
+			_role_copy_in_impl = "copy_in_impl", ///< The implementation of a copy-in function.
+			_role_snapshot = "snapshot", ///< The API function pointer that copies fields of a record into its view.
+			_role_snapshot_impl = "snapshot_impl", ///< The implementation of a snapshot function.
+			_role_apply = "apply", ///< The API function pointer that writes fields of a view back into a record.
+			_role_apply_impl = "apply_impl"; ///< The implementation of an apply function.
+
+		/// The maximum number of fields in a view, which is the number of bits in the masks of apply functions.
+		constexpr static std::size_t _max_view_fields = 64;
+
+		/// Mapping between the names shortened by \ref naming_convention::shorten_name() and their full spellings.
+		/// Only names that have been frozen are recorded, not the candidates rejected by the name allocator.
+		std::map<std::string, std::string> _shortened_names;
+		/// The number of worker threads currently started by export functions, which is at most
+		/// <cc>num_threads - 1</cc>. Concurrent calls share this count instead of each starting \ref num_threads.
+		mutable std::atomic<std::size_t> _busy_workers = 0;
+		/// Names reserved from \ref ledger, indexed by their keys.
+		std::map<std::string, name_allocator::token, std::less<>> _reserved_names;
+		/// The keys of all names that should be recorded in \ref ledger.
+		std::vector<std::pair<std::string, const name_allocator::name_info*>> _ledger_names;
+		/// Names of the size and version members of the API structure when \ref slot_layout is used.
+		std::vector<name_allocator::token> _layout_member_names;
+		/// Names of direct-link functions when \ref direct_link is \p true, indexed by the names of the corresponding
+		/// function pointers.
+		std::unordered_map<std::string_view, cached_name> _direct_names;
+
+		/// Returns all entities in the registry that are marked for exporting, sorted in the order they're declared
+		/// in the translation unit. Entities declared at the same location are sorted by their USRs.
+		[[nodiscard]] static std::vector<entity*> _get_exported_entities_in_declaration_order(const entity_registry&);
+		/// Returns the name of the outermost named namespace that contains the given declaration, or an empty string
+		/// if it's not in a named namespace.
+		[[nodiscard]] static std::string_view get_top_level_namespace(const clang::Decl*);
+		/// Returns the API group of the given entity, which is its top-level namespace if \ref split_api_header is
+		/// \p true, or an empty string otherwise.
+		[[nodiscard]] std::string_view _get_api_group(const entities::function_entity *ent) const {
+			return split_api_header ? get_top_level_namespace(ent->get_declaration()) : std::string_view();
+		}
+		/// \overload
+		[[nodiscard]] std::string_view _get_api_group(const entities::record_entity *ent) const {
+			return split_api_header ? get_top_level_namespace(ent->get_declaration()) : std::string_view();
+		}
+		/// \overload
+		[[nodiscard]] std::string_view _get_api_group(const entities::field_entity *ent) const {
+			return split_api_header ? get_top_level_namespace(ent->get_declaration()) : std::string_view();
+		}
+		/// Enums have no table members, so they belong to the root group unless their namespace has a group.
+		[[nodiscard]] std::string_view _get_api_group(const entities::enum_entity *ent) const {
+			if (!split_api_header) {
+				return std::string_view();
+			}
+			std::string_view group = get_top_level_namespace(ent->get_declaration());
+			return _api_groups.find(group) != _api_groups.end() ? group : std::string_view();
+		}
+		/// Custom functions are always in the root group.
+		[[nodiscard]] std::string_view _get_api_group(const custom_function_entity*) const {
+			return std::string_view();
+		}
+		/// Collects the API groups of the given entities and allocates names for them.
+		void _collect_api_groups(const std::vector<entity*>&);
+		/// Returns the prefix used to access members of the given group's sub-table in the API structure.
+		[[nodiscard]] std::string _get_api_table_member_prefix(std::string_view group) const;
+
+		/// Freezes the given name, and records it in \ref _shortened_names if it has been shortened.
+		void _freeze(cached_name&);
+		/// Reserves names in \ref ledger for all exported entities that still exist. The names are reserved for all
+		/// roles in the ledger, including roles that turn out to be no longer generated; such names stay reserved
+		/// until the end of this run, but are not recorded in \ref ledger again.
+		void _reserve_ledger_names(const entity_registry&, name_allocator &api_table_scope);
+		/// Registers a name for the given declaration. If \ref ledger is not \p nullptr and the declaration has been
+		/// assigned a name with the same role in a previous run, the reserved name is used instead.
+		cached_name _register_name(
+			name_allocator&, const clang::Decl*, std::string_view role, naming_convention::name_info,
+			std::string_view prefix = ""
+		);
+		/// If the given type is a vector type of a builtin element type that has not been registered, allocates a
+		/// name for its typedef in the API header.
+		void _register_vector_type(const clang::Type*, const clang::ASTContext&);
+		/// Returns whether the given type is a fixed-size array that's exported as a typedef of an array type. This
+		/// is the case if its elements are builtin types, enums, or vector types.
+		[[nodiscard]] static bool _is_typed_array(const qualified_type&);
+		/// Returns the key of the given array type in \ref _array_type_names, which is its spelling in the API header
+		/// without qualifiers, e.g., <cc>float[4][4]</cc>.
+		[[nodiscard]] std::string _get_array_type_key(const qualified_type&) const;
+		/// Allocates a name for the typedef of the given array type in the API header if it has not been registered.
+		void _register_array_type(const qualified_type&);
+		/// Returns why the batch variant of the given function cannot be exported, or an empty string if it can. The
+		/// variant can be exported for functions that are neither constructors nor variadic, and whose parameters and
+		/// return type are not records that are passed through pointers to copies or to memory provided by the
+		/// caller.
+		[[nodiscard]] std::string _get_batch_rejection_reason(entities::function_entity*) const;
+		/// Registers the names of the batch variant of the given function if it's marked with \p APIGEN_BATCH and
+		/// the variant can be exported.
+		void _register_batch_function(entities::function_entity*, function_naming&);
+		/// Returns the type of the array that holds the arguments or the return values of the batch variant of a
+		/// function for the given parameter or return type. References are stored as pointers in the array, and
+		/// top-level qualifiers of the elements are replaced by \p const for input arrays.
+		[[nodiscard]] static qualified_type _get_batch_array_type(const qualified_type&, bool input);
+		/// Returns whether the given field is copied into the view of its parent record. This is the case for named
+		/// fields that are neither references nor arrays, whose types are builtin types, enums, vectors, or pointers
+		/// to builtin types, enums, and exported records.
+		[[nodiscard]] bool _is_view_field(const entities::field_entity*) const;
+		/// Returns whether the given view field can be written back by the apply function, i.e., it's not const.
+		[[nodiscard]] static bool _is_view_field_writable(const entities::field_entity *field) {
+			return field->get_field_kind() != entities::field_kind::const_field;
+		}
+		/// Limits the number of fields in the view of the given record to \ref _max_view_fields, and registers the
+		/// names of its snapshot and apply functions if the view is not empty.
+		void _register_record_view(
+			entities::record_entity*, record_naming&, name_allocator &api_table_scope
+		);
+
 		function_name_mapping _function_names; ///< Mapping between functions and their exported names.
 		enum_name_mapping _enum_names; ///< Mapping between enums and their exported names.
 		record_name_mapping _record_names; ///< Mapping between records and their exported names.
 		field_name_mapping _field_names; ///< Mapping between fields and their exported names.
+		/// Mapping between array types of exported fields and their exported names.
+		array_type_name_mapping _array_type_names;
+		/// Mapping between vector types used by exported functions and fields and their exported names.
+		vector_type_name_mapping _vector_type_names;
 		/// Mapping between custom functions and their exported names.
 		custom_function_name_mapping _custom_func_names;
+		/// Names of API groups when \ref split_api_header is \p true, indexed by their top-level namespaces.
+		std::map<std::string, api_group_naming, std::less<>> _api_groups;
 		name_allocator
 			_global_scope, ///< The \ref name_allocator for the global scope.
 			_impl_scope; ///< The \ref name_allocator for the scope that contain API implementations.
@@ -363,5 +1096,16 @@ namespace apigen {
 
 		/// Exports the code used to pass a parameter.
 		void _export_pass_parameter(cpp_writer&, const qualified_type&, std::string_view) const;
+
+		// manifest
+		/// Converts a \ref qualified_type into an \ref api_manifest::type_info.
+		[[nodiscard]] api_manifest::type_info _get_manifest_type(const qualified_type&) const;
+		/// Builds the description of the API table of the given group.
+		[[nodiscard]] api_manifest::table_info _build_manifest_table(
+			std::string_view struct_name, std::string_view group
+		) const;
+		/// Fills the description of the view of the given record. Views only hold builtin types, enums, vectors,
+		/// and pointers, so their layout follows from the sizes and alignments of their fields.
+		void _build_manifest_view(api_manifest::record_info&, const record_naming&) const;
 	};
 }
@@ -151,6 +151,9 @@ namespace apigen {
 		if (auto *tagty = llvm::dyn_cast<clang::TagType>(type)) {
 			return get_internal_entity_name(tagty->getAsTagDecl());
 		}
+		if (llvm::isa<clang::VectorType>(type)) { // spelled with the vector attribute
+			return clang::QualType(type, 0).getAsString(policy);
+		}
 		assert_true(
 			!llvm::isa<clang::FunctionProtoType>(type),
 			"get_internal_type_name cannot handle function types; "
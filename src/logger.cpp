@@ -0,0 +1,110 @@
+#include "logger.h"
+
+/// \file
+/// Implementation of \ref apigen::logger.
+
+namespace apigen {
+	std::string_view logger::get_level_name(log_level level) {
+		switch (level) {
+		case log_level::error:
+			return "error";
+		case log_level::warning:
+			return "warning";
+		case log_level::info:
+			return "info";
+		case log_level::debug:
+			return "debug";
+		}
+		return "$BAD_LEVEL";
+	}
+
+	std::string_view logger::get_category_name(log_category cat) {
+		switch (cat) {
+		case log_category::general:
+			return "general";
+		case log_category::parsing:
+			return "parsing";
+		case log_category::dependency:
+			return "dependency";
+		case log_category::naming:
+			return "naming";
+		case log_category::exporting:
+			return "exporting";
+		default:
+			break;
+		}
+		return "$BAD_CATEGORY";
+	}
+
+	std::optional<log_level> logger::parse_level(std::string_view name) {
+		for (log_level level : { log_level::error, log_level::warning, log_level::info, log_level::debug }) {
+			if (get_level_name(level) == name) {
+				return level;
+			}
+		}
+		return std::nullopt;
+	}
+
+	std::optional<log_category> logger::parse_category(std::string_view name) {
+		for (std::size_t i = 0; i < static_cast<std::size_t>(log_category::max_value); ++i) {
+			auto cat = static_cast<log_category>(i);
+			if (get_category_name(cat) == name) {
+				return cat;
+			}
+		}
+		return std::nullopt;
+	}
+
+	void logger::_append(log_category cat, log_level level, std::string_view message) {
+		std::lock_guard<std::mutex> guard(_mutex);
+		if (_json) {
+			_buffer += R"({"level":")";
+			_buffer += get_level_name(level);
+			_buffer += R"(","category":")";
+			_buffer += get_category_name(cat);
+			_buffer += R"(","message":)";
+			_append_json_string(message);
+			_buffer += "}\n";
+		} else {
+			_buffer += get_level_name(level);
+			_buffer += ": ";
+			_buffer += message;
+			_buffer += "\n";
+		}
+		// errors are written immediately so that they're not lost if the program aborts
+		if (level == log_level::error || _buffer.size() >= flush_threshold) {
+			_flush_buffer();
+		}
+	}
+
+	void logger::_append_json_string(std::string_view str) {
+		_buffer += '"';
+		for (char c : str) {
+			switch (c) {
+			case '"':
+				_buffer += "\\\"";
+				break;
+			case '\\':
+				_buffer += "\\\\";
+				break;
+			case '\n':
+				_buffer += "\\n";
+				break;
+			case '\r':
+				_buffer += "\\r";
+				break;
+			case '\t':
+				_buffer += "\\t";
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					_buffer += fmt::format("\\u{:04x}", static_cast<unsigned int>(c));
+				} else {
+					_buffer += c;
+				}
+				break;
+			}
+		}
+		_buffer += '"';
+	}
+}
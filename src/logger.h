@@ -0,0 +1,127 @@
+#pragma once
+
+/// \file
+/// Leveled and buffered logging.
+
+#include <array>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+namespace apigen {
+	/// The severity of a log message. Larger values indicate more verbose messages.
+	enum class log_level : unsigned char {
+		error, ///< Errors.
+		warning, ///< Warnings.
+		info, ///< General progress information.
+		debug ///< Detailed information about individual entities.
+	};
+	/// The category of a log message, used to toggle messages from specific parts of apigen.
+	enum class log_category : unsigned char {
+		general, ///< Messages that do not belong to any specific category.
+		parsing, ///< Messages emitted when parsing source code and annotations.
+		dependency, ///< Messages emitted when analyzing dependencies.
+		naming, ///< Messages emitted when naming entities.
+		exporting, ///< Messages emitted when generating code.
+
+		max_value ///< The number of categories.
+	};
+
+	/// A leveled logger that buffers messages and writes them to an output stream in large chunks. Messages below
+	/// the verbosity level or in disabled categories are discarded before they're formatted. Messages can be logged
+	/// from multiple threads, but the configuration should not be changed while doing so.
+	class logger {
+	public:
+		/// The number of buffered bytes that triggers a flush.
+		constexpr static std::size_t flush_threshold = 64 * 1024;
+
+		/// Initializes \ref _out.
+		explicit logger(std::ostream &out) : _out(&out) {
+			_categories.fill(true);
+		}
+		/// No copy construction.
+		logger(const logger&) = delete;
+		/// No copy assignment.
+		logger &operator=(const logger&) = delete;
+		/// Flushes all remaining messages.
+		~logger() {
+			flush();
+		}
+
+		/// Returns the global logger that writes to \p std::cerr.
+		[[nodiscard]] inline static logger &get() {
+			static logger _global(std::cerr);
+			return _global;
+		}
+
+		/// Returns whether messages of the given category and level will be written. Callers should check this
+		/// before doing any work to compute message arguments.
+		[[nodiscard]] bool is_enabled(log_category cat, log_level level) const {
+			return level <= _verbosity && _categories[static_cast<std::size_t>(cat)];
+		}
+		/// Formats and logs a message if it's enabled.
+		template <typename ...Args> void log(log_category cat, log_level level, Args &&...args) {
+			if (is_enabled(cat, level)) {
+				_append(cat, level, fmt::format(std::forward<Args>(args)...));
+			}
+		}
+		/// Writes all buffered messages to the output.
+		void flush() {
+			std::lock_guard<std::mutex> guard(_mutex);
+			_flush_buffer();
+		}
+
+		/// Sets the maximum level of messages that are written.
+		void set_verbosity(log_level level) {
+			_verbosity = level;
+		}
+		/// Enables or disables messages of the given category.
+		void set_category_enabled(log_category cat, bool enabled) {
+			_categories[static_cast<std::size_t>(cat)] = enabled;
+		}
+		/// Enables or disables all categories.
+		void set_all_categories_enabled(bool enabled) {
+			_categories.fill(enabled);
+		}
+		/// Sets whether messages are written as JSON objects, one per line.
+		void set_json_output(bool json) {
+			_json = json;
+		}
+
+		/// Returns the name of the given \ref log_level.
+		[[nodiscard]] static std::string_view get_level_name(log_level);
+		/// Returns the name of the given \ref log_category.
+		[[nodiscard]] static std::string_view get_category_name(log_category);
+		/// Parses a \ref log_level from its name.
+		[[nodiscard]] static std::optional<log_level> parse_level(std::string_view);
+		/// Parses a \ref log_category from its name.
+		[[nodiscard]] static std::optional<log_category> parse_category(std::string_view);
+	protected:
+		std::string _buffer; ///< Messages that have not been written yet.
+		std::ostream *_out = nullptr; ///< The output stream.
+		/// Whether each category is enabled.
+		std::array<bool, static_cast<std::size_t>(log_category::max_value)> _categories;
+		log_level _verbosity = log_level::warning; ///< The maximum level of messages that are written.
+		bool _json = false; ///< Whether to write messages as JSON lines.
+		std::mutex _mutex; ///< Protects \ref _buffer and \ref _out.
+
+		/// Writes all buffered messages to the output. The caller must hold \ref _mutex.
+		void _flush_buffer() {
+			if (!_buffer.empty()) {
+				_out->write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+				_out->flush();
+				_buffer.clear();
+			}
+		}
+
+		/// Appends a formatted message to \ref _buffer, and flushes it if necessary.
+		void _append(log_category, log_level, std::string_view);
+		/// Appends the given string to \ref _buffer as a JSON string literal.
+		void _append_json_string(std::string_view);
+	};
+}
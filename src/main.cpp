@@ -1,13 +1,22 @@
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
+#include <future>
+#include <iterator>
+#include <sstream>
+#include <thread>
 
 #include <clang/Lex/PreprocessorOptions.h>
 
+#include <llvm/Support/Process.h>
+
 #include <gflags/gflags.h>
 
 #include "dependency_analyzer.h"
 #include "entity_registry.h"
 #include "exporter.h"
+#include "logger.h"
+#include "manifest.h"
 #include "parser.h"
 #include "basic_naming_convention.h"
 
@@ -22,6 +31,24 @@ DEFINE_string(
 	"Path to the auxiliary output file used to collect structure sizes and alignments."
 );
 
+DEFINE_string(
+	api_module_file, "",
+	"Path to a C++20 module interface unit that exports everything in the API header, so that C++ clients can import "
+	"a prebuilt module instead of including the header. Not specifying a value disables this output."
+);
+DEFINE_string(api_module_name, "apigen.api", "Name of the C++20 module that exports the API.");
+
+DEFINE_string(
+	manifest_json_file, "",
+	"Path to a JSON manifest that describes every slot of the API tables and all exported records and enums. Not "
+	"specifying a value disables this output."
+);
+DEFINE_string(
+	manifest_binary_file, "",
+	"Path to the same manifest in a compact binary format that can be read without parsing. Not specifying a value "
+	"disables this output."
+);
+
 DEFINE_string(
 	additional_host_include, "",
 	"Path to an additional include file for all host sources. Not specifying a value causes no additional "
@@ -30,13 +57,125 @@ DEFINE_string(
 
 // debugging
 DEFINE_string(redirect_stderr, "", "The redirected stderr file name.");
+DEFINE_string(verbosity, "warning", "The maximum level of logged messages: error, warning, info, or debug.");
+DEFINE_string(
+	log_categories, "all",
+	"Comma-separated list of enabled log categories: general, parsing, dependency, naming, exporting, or all."
+);
+DEFINE_bool(log_json, false, "Writes log messages as JSON objects, one per line.");
+
+// performance
+DEFINE_uint64(
+	host_shards, 1,
+	"Number of source files that the host implementations are split into. When this is larger than 1, the host "
+	"source file only contains the API initialization function, and the implementations are written to files "
+	"named after it with a shard index appended, e.g., host_0.cpp. Shards left over from previous runs that used more "
+	"shards are deleted."
+);
+DEFINE_uint64(
+	jobs, 0,
+	"Number of threads used to generate code. Zero indicates the number of hardware threads. Output files are "
+	"always written concurrently, and share this number of threads."
+);
+
+DEFINE_bool(
+	split_api_header, false,
+	"Splits the API header by top-level namespaces. Each namespace gets its own header named after the API header "
+	"(e.g., api_ns.h) that contains a sub-table of function pointers and the enumerators, record layouts, views, and "
+	"inline accessors of the namespace. api_fwd.h declares all exported types, and only defines those that can be "
+	"used by value in other namespaces. The API header itself includes all of them."
+);
+DEFINE_bool(
+	direct_link, false,
+	"Also declares every API function except custom functions as an extern \"C\" function in the API header, named "
+	"after the function pointer with the API structure name as a prefix (e.g., api_foo), and defines it in the host "
+	"source files. Statically linked clients can call these directly so that calls can be inlined with LTO, while "
+	"the function pointer table remains available for dynamically loaded clients."
+);
+DEFINE_bool(
+	elide_wrappers, true,
+	"Stores the addresses of free and static member functions directly in the API structure when their signatures "
+	"only involve builtin types and pointers to them, instead of going through wrapper functions."
+);
+DEFINE_bool(
+	record_layouts, true,
+	"Emits the size and alignment of every exported record as constants in the API header (e.g., foo_size and "
+	"foo_align), together with a suitably aligned storage structure (e.g., foo_storage) that clients can use to hold "
+	"objects without allocating. The host checks these values against the actual types at compile time."
+);
+DEFINE_uint64(
+	by_value_record_size, 0,
+	"Trivially copyable standard-layout structs no larger than this number of bytes, whose fields are all public and "
+	"only involve builtin types, are defined in full in the API header and passed and returned by value instead of "
+	"through pointers. This changes the signatures of existing functions that take or return such structs, so "
+	"clients must be updated when it's turned on. 0 (the default) keeps all records opaque."
+);
+DEFINE_bool(
+	inline_field_access, true,
+	"Defines inline getters in the API header for fields of standard-layout records (e.g., foo_x_getter_inline) "
+	"that compute field addresses from their offsets, so that accessing fields does not require calling through the "
+	"API structure. The host checks the offsets at compile time."
+);
+DEFINE_bool(
+	record_views, true,
+	"Defines a view struct in the API header for every record whose members are all exported (e.g., foo_view) that "
+	"holds copies of its scalar, enum, vector, and pointer fields, together with functions that fill the view in one "
+	"call (e.g., foo_snapshot) and write the fields selected by a bit mask back (e.g., foo_apply)."
+);
 
 // naming
 DEFINE_string(api_struct_name, "api", "Name of the API structure containing function pointers.");
 DEFINE_string(api_initializer_name, "api_init", "Name of the function used to initialize the API structure.");
+DEFINE_uint64(
+	max_name_length, 0,
+	"Maximum length of names in the API header, including disambiguation postfixes. Longer names are truncated and "
+	"a hash of the full name is appended. The limit must leave room for at least one character before the hash. Zero "
+	"indicates no limit."
+);
+DEFINE_uint64(
+	name_hash_length, 8, "Number of hexadecimal digits of the hash appended to shortened names, between 1 and 16."
+);
+DEFINE_string(
+	short_name_map_file, "",
+	"Path to a file that receives the mapping between shortened names and their full spellings, one pair per line "
+	"separated by a tab. Not specifying a value disables this output."
+);
+DEFINE_string(
+	name_ledger_file, "",
+	"Path to a file that stores the names assigned to exported entities. Names recorded in this file are reused in "
+	"subsequent runs so that they stay stable when other entities are added or removed. The file is updated after "
+	"each run. Not specifying a value disables this feature."
+);
+DEFINE_string(
+	slot_ledger_file, "",
+	"Path to a file that stores the layout of the API structure. When specified, the structure begins with its size "
+	"and a layout version, new members are always appended, and members of removed entities are kept as "
+	"tombstones, so that clients built against older layouts keep working. The file is updated after each run. "
+	"This should be used together with --name_ledger_file so that member names stay the same, and cannot be used "
+	"with --split_api_header."
+);
+DEFINE_string(
+	compare_to, "",
+	"Path to a binary manifest written by a previous run. The current API is compared against it, and the exit status "
+	"indicates whether clients need to be rebuilt: 0 if nothing changed, 2 if the change is additive, and 3 if it "
+	"breaks existing clients. A missing or malformed manifest counts as a breaking change. A manifest written in "
+	"another version of the binary format cannot be compared; the exit status is then 4, and no output is written."
+);
 
 // TODO naming convention parameters
 
+/// Exit statuses of the program. Apart from \ref exit_output_error and \ref exit_invalid_arguments, these are used
+/// by the \p --compare_to mode.
+enum exit_status : int {
+	exit_no_change = 0, ///< No change, or \p --compare_to is not used.
+	exit_output_error = 1, ///< At least one output file could not be written.
+	exit_additive_change = 2, ///< Only additive changes.
+	exit_breaking_change = 3, ///< At least one breaking change.
+	/// The command line flags are invalid, or the manifest passed to \p --compare_to is written in another version of
+	/// the binary format; nothing is written.
+	exit_invalid_arguments = 4
+};
+
 /// Concatenates the current working directory with \p p, then emits a warning if the root of the resulting path is
 /// different from that of the current working directory.
 std::filesystem::path get_absolute_path(const std::filesystem::path &p) {
@@ -44,19 +183,166 @@ std::filesystem::path get_absolute_path(const std::filesystem::path &p) {
 
 	std::filesystem::path fulldir = (_working_dir / p).lexically_normal();
 	if (fulldir.root_name() != _working_dir.root_name()) {
-		std::cerr <<
-			"warning: files are on different roots (partitions). this is currently unsupported by apigen.\n"
-			"note that this only affects generated #include directives (invalid ones will be generated), while other codegen "
-			"features are unaffected.\n";
+		logger::get().log(
+			log_category::general, log_level::warning,
+			"files are on different roots (partitions). this is currently unsupported by apigen. "
+			"note that this only affects generated #include directives (invalid ones will be generated), while other "
+			"codegen features are unaffected."
+		);
 	}
 	return fulldir;
 }
+/// Configures \ref logger::get() using command line flags.
+void configure_logger() {
+	logger &log = logger::get();
+	log.set_json_output(FLAGS_log_json);
+	if (auto level = logger::parse_level(FLAGS_verbosity)) {
+		log.set_verbosity(level.value());
+	} else {
+		log.log(log_category::general, log_level::warning, "unknown verbosity level: {}", FLAGS_verbosity);
+	}
+	if (FLAGS_log_categories != "all") {
+		std::vector<log_category> enabled;
+		std::string_view list = FLAGS_log_categories;
+		while (!list.empty()) {
+			std::size_t sep = list.find(',');
+			std::string_view name = list.substr(0, sep);
+			if (auto cat = logger::parse_category(name)) {
+				enabled.emplace_back(cat.value());
+			} else if (!name.empty()) {
+				log.log(log_category::general, log_level::warning, "unknown log category: {}", name);
+			}
+			list.remove_prefix(sep == std::string_view::npos ? list.size() : sep + 1);
+		}
+		log.set_all_categories_enabled(false);
+		for (log_category cat : enabled) {
+			log.set_category_enabled(cat, true);
+		}
+	}
+}
 /// Returns the path required if a file at \p sourceloc needs to include the file at \p included.
 std::filesystem::path get_relative_include_path(
 	const std::filesystem::path &included, const std::filesystem::path &sourceloc
 ) {
 	return included.lexically_relative(sourceloc.parent_path());
 }
+/// Returns the path of a file next to the given file, with an underscore and the given suffix appended to its stem.
+/// This is used for additional output files, e.g., <cc>host.cpp</cc> becomes <cc>host_0.cpp</cc>.
+std::filesystem::path get_suffixed_path(const std::filesystem::path &path, std::string_view suffix) {
+	std::filesystem::path result = path.parent_path();
+	result /= path.stem().string() + "_" + std::string(suffix) + path.extension().string();
+	return result;
+}
+/// Writes the given contents to the file at the given path, but only if the file does not already have exactly the
+/// same contents, so that its modification time is preserved. The file is replaced atomically by renaming a
+/// temporary file, which is removed if anything fails. The name of the temporary file contains the process ID, so
+/// that concurrent runs writing to the same directory don't overwrite each other's temporary files.
+///
+/// \return Whether the file now holds the given contents.
+[[nodiscard]] bool write_output_file(const std::filesystem::path &path, std::string_view contents) {
+	std::error_code ec;
+	if (std::filesystem::file_size(path, ec) == contents.size() && !ec) {
+		std::ifstream in(path, std::ios::binary);
+		std::string existing(std::istreambuf_iterator<char>(in), {});
+		if (existing == contents) {
+			logger::get().log(log_category::general, log_level::info, "unchanged: {}", path.string());
+			return true;
+		}
+	}
+
+	std::filesystem::path temp_path = path;
+	temp_path += "." + std::to_string(llvm::sys::Process::getProcessId()) + ".tmp";
+	{
+		std::ofstream out(temp_path, std::ios::binary);
+		out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+		out.close();
+		if (!out) {
+			logger::get().log(log_category::general, log_level::error, "failed to write: {}", temp_path.string());
+			std::filesystem::remove(temp_path, ec);
+			return false;
+		}
+	}
+	std::filesystem::rename(temp_path, path, ec);
+	if (ec) {
+		logger::get().log(
+			log_category::general, log_level::error, "failed to replace {}: {}", path.string(), ec.message()
+		);
+		std::filesystem::remove(temp_path, ec);
+		return false;
+	}
+	logger::get().log(log_category::general, log_level::info, "updated: {}", path.string());
+	return true;
+}
+/// Removes the host source shards left behind by previous runs that used more shards, starting from the shard with
+/// the given index. Shards are always numbered consecutively, so this stops at the first missing file.
+///
+/// \return Whether all stale shards have been removed.
+[[nodiscard]] bool remove_stale_host_shards(const std::filesystem::path &host_source, std::size_t first) {
+	for (std::size_t i = first; ; ++i) {
+		std::filesystem::path shard_source = get_suffixed_path(host_source, std::to_string(i));
+		std::error_code ec;
+		if (!std::filesystem::exists(shard_source, ec)) {
+			return true;
+		}
+		if (!std::filesystem::remove(shard_source, ec)) {
+			logger::get().log(
+				log_category::general, log_level::error, "failed to remove stale shard {}: {}",
+				shard_source.string(), ec.message()
+			);
+			return false;
+		}
+		logger::get().log(log_category::general, log_level::info, "removed stale shard: {}", shard_source.string());
+	}
+}
+
+/// Compares the current manifest against the binary manifest at the given path, logs all differences, and returns
+/// the corresponding \ref exit_status.
+int compare_to_previous_manifest(const std::filesystem::path &path, const api_manifest &current) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		logger::get().log(
+			log_category::general, log_level::warning, "cannot open previous manifest: {}", path.string()
+		);
+		return exit_breaking_change;
+	}
+	std::string data(std::istreambuf_iterator<char>(in), {});
+	if (std::optional<std::uint32_t> version = api_manifest_view::get_version(data)) {
+		if (version.value() != api_manifest::binary_version) {
+			logger::get().log(
+				log_category::general, log_level::error,
+				"previous manifest {} is in version {} of the binary format, but this program reads version {}; "
+				"regenerate it with this version of apigen",
+				path.string(), version.value(), api_manifest::binary_version
+			);
+			return exit_invalid_arguments;
+		}
+	}
+	std::optional<api_manifest> previous = api_manifest::read_binary(data);
+	if (!previous) {
+		logger::get().log(
+			log_category::general, log_level::warning, "malformed previous manifest: {}", path.string()
+		);
+		return exit_breaking_change;
+	}
+
+	api_manifest_diff diff = api_manifest_diff::compare(previous.value(), current);
+	for (const std::string &desc : diff.breakages) {
+		logger::get().log(log_category::general, log_level::warning, "breaking change: {}", desc);
+	}
+	for (const std::string &desc : diff.additions) {
+		logger::get().log(log_category::general, log_level::info, "additive change: {}", desc);
+	}
+	switch (diff.change) {
+	case abi_change::none:
+		logger::get().log(log_category::general, log_level::info, "API unchanged");
+		return exit_no_change;
+	case abi_change::additive:
+		return exit_additive_change;
+	case abi_change::breaking:
+		break;
+	}
+	return exit_breaking_change;
+}
 
 int main(int argc, char **argv) {
 	argv[0] = "clang++";
@@ -81,6 +367,7 @@ int main(int argc, char **argv) {
 		stderr_redirect.open(FLAGS_redirect_stderr, std::ios::out | std::ios::trunc);
 		std::cerr.rdbuf(stderr_redirect.rdbuf());
 	}
+	configure_logger();
 
 	auto invocation = clang::createInvocationFromCommandLine(args);
 
@@ -92,7 +379,20 @@ int main(int argc, char **argv) {
 
 	reg.analyzer = &dep_analyzer;
 
+	// naming convention, checked before parsing so that invalid flags are reported early
+	basic_naming_convention naming(reg);
+	naming.api_struct_name = FLAGS_api_struct_name;
+	naming.api_struct_init_function_name = FLAGS_api_initializer_name;
+	naming.max_name_length = FLAGS_max_name_length;
+	naming.name_hash_length = FLAGS_name_hash_length;
+	if (!naming.check_name_length_limits()) {
+		logger::get().flush();
+		return exit_invalid_arguments;
+	}
+
+	logger::get().log(log_category::general, log_level::info, "parsing");
 	p.parse(reg);
+	logger::get().log(log_category::general, log_level::info, "analyzing dependencies");
 	dep_analyzer.analyze(reg);
 
 	// process paths
@@ -105,37 +405,184 @@ int main(int argc, char **argv) {
 	if (!FLAGS_additional_host_include.empty()) {
 		additional_host_include = get_absolute_path(FLAGS_additional_host_include);
 	} else {
-		std::cerr << "warning: no additional host includes specified.\n";
+		logger::get().log(log_category::general, log_level::warning, "no additional host includes specified.");
 	}
 
-	// naming convention
-	basic_naming_convention naming(reg);
-	naming.api_struct_name = FLAGS_api_struct_name;
-	naming.api_struct_init_function_name = FLAGS_api_initializer_name;
-
 	// export!
 	exporter exp(p.get_compiler().getASTContext().getPrintingPolicy(), naming, reg);
+	exp.num_threads = FLAGS_jobs;
+	if (exp.num_threads == 0) {
+		exp.num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	name_ledger ledger;
+	std::filesystem::path ledger_path;
+	if (!FLAGS_name_ledger_file.empty()) {
+		ledger_path = get_absolute_path(FLAGS_name_ledger_file);
+		if (std::filesystem::exists(ledger_path)) {
+			std::ifstream in(ledger_path);
+			ledger.load(in);
+		}
+		exp.ledger = &ledger;
+	}
+	slot_ledger slots;
+	std::filesystem::path slot_ledger_path;
+	if (!FLAGS_slot_ledger_file.empty()) {
+		slot_ledger_path = get_absolute_path(FLAGS_slot_ledger_file);
+		if (std::filesystem::exists(slot_ledger_path)) {
+			std::ifstream in(slot_ledger_path);
+			slots.load(in);
+		}
+		exp.slot_layout = &slots;
+		if (FLAGS_split_api_header) {
+			// sub-tables are embedded in the API structure, so they cannot grow without moving other members
+			logger::get().log(
+				log_category::general, log_level::warning,
+				"--split_api_header is ignored since --slot_ledger_file is specified"
+			);
+			FLAGS_split_api_header = false;
+		}
+	}
+	exp.split_api_header = FLAGS_split_api_header;
+	exp.direct_link = FLAGS_direct_link;
+	exp.elide_wrappers = FLAGS_elide_wrappers;
+	exp.export_record_layouts = FLAGS_record_layouts;
+	exp.by_value_record_size = FLAGS_by_value_record_size;
+	exp.inline_field_access = FLAGS_inline_field_access;
+	exp.record_views = FLAGS_record_views;
+	logger::get().log(log_category::general, log_level::info, "collecting exported entities");
 	exp.collect_exported_entities(reg);
-	{
-		std::ofstream out(api_header);
-		exp.export_api_header(out);
+	// the manifest is built before any output is written, since the previous manifest may be overwritten
+	std::optional<api_manifest> manifest;
+	int status = exit_no_change;
+	if (!FLAGS_manifest_json_file.empty() || !FLAGS_manifest_binary_file.empty() || !FLAGS_compare_to.empty()) {
+		manifest.emplace(exp.build_manifest());
+		if (!FLAGS_compare_to.empty()) {
+			status = compare_to_previous_manifest(get_absolute_path(FLAGS_compare_to), manifest.value());
+			if (status == exit_invalid_arguments) {
+				logger::get().flush();
+				return status;
+			}
+		}
 	}
-	{
-		std::ofstream out(host_header);
+	logger::get().log(log_category::general, log_level::info, "writing output files");
+	bool outputs_written = true;
+	if (!FLAGS_short_name_map_file.empty()) {
+		std::ostringstream out;
+		for (auto &&[short_name, full_name] : exp.get_shortened_names()) {
+			out << short_name << "\t" << full_name << "\n";
+		}
+		outputs_written = write_output_file(get_absolute_path(FLAGS_short_name_map_file), out.str());
+	}
+	// the output files are independent, so they're written concurrently
+	std::vector<std::future<bool>> outputs;
+	if (!FLAGS_split_api_header) {
+		outputs.emplace_back(std::async(std::launch::async, [&]() {
+			std::ostringstream out;
+			exp.export_api_header(out);
+			return write_output_file(api_header, out.str());
+		}));
+	} else {
+		std::filesystem::path api_forward_header = get_suffixed_path(api_header, "fwd");
+		auto write_include = [](
+			std::ostream &out, const std::filesystem::path &header, const std::filesystem::path &file
+		) {
+			out << "#include \"" << get_relative_include_path(header, file).string() << "\"\n";
+		};
+		outputs.emplace_back(std::async(std::launch::async, [&, api_forward_header]() {
+			std::ostringstream out;
+			out << "#pragma once\n";
+			write_include(out, api_forward_header, api_header);
+			for (auto &&[group, name] : exp.get_api_groups()) {
+				write_include(out, get_suffixed_path(api_header, group), api_header);
+			}
+			exp.export_api_header(out);
+			return write_output_file(api_header, out.str());
+		}));
+		outputs.emplace_back(std::async(std::launch::async, [&, api_forward_header]() {
+			std::ostringstream out;
+			out << "#pragma once\n";
+			exp.export_api_forward_header(out);
+			return write_output_file(api_forward_header, out.str());
+		}));
+		for (auto &&[group_name, group_naming] : exp.get_api_groups()) {
+			std::string_view group = group_name;
+			outputs.emplace_back(std::async(std::launch::async, [&, api_forward_header, group]() {
+				std::filesystem::path group_header = get_suffixed_path(api_header, group);
+				std::ostringstream out;
+				out << "#pragma once\n";
+				write_include(out, api_forward_header, group_header);
+				exp.export_api_group_header(out, group);
+				return write_output_file(group_header, out.str());
+			}));
+		}
+	}
+	outputs.emplace_back(std::async(std::launch::async, [&]() {
+		std::ostringstream out;
 		exp.export_host_h(out);
+		return write_output_file(host_header, out.str());
+	}));
+	if (!FLAGS_api_module_file.empty()) {
+		outputs.emplace_back(std::async(std::launch::async, [&]() {
+			std::filesystem::path api_module = get_absolute_path(FLAGS_api_module_file);
+			std::ostringstream out;
+			exp.export_api_module(
+				out, FLAGS_api_module_name, get_relative_include_path(api_header, api_module).generic_string()
+			);
+			return write_output_file(api_module, out.str());
+		}));
 	}
-	{
-		std::ofstream out(host_source);
+	if (!FLAGS_manifest_json_file.empty() || !FLAGS_manifest_binary_file.empty()) {
+		outputs.emplace_back(std::async(std::launch::async, [&]() {
+			bool written = true;
+			if (!FLAGS_manifest_json_file.empty()) {
+				std::ostringstream out;
+				manifest->write_json(out);
+				written = write_output_file(get_absolute_path(FLAGS_manifest_json_file), out.str());
+			}
+			if (!FLAGS_manifest_binary_file.empty()) {
+				std::ostringstream out;
+				manifest->write_binary(out);
+				written = write_output_file(get_absolute_path(FLAGS_manifest_binary_file), out.str()) && written;
+			}
+			return written;
+		}));
+	}
+	auto write_host_source_includes = [&](std::ostream &out, const std::filesystem::path &source) {
 		if (!additional_host_include.empty()) {
-			out <<
-				"#include \"" << get_relative_include_path(additional_host_include, host_source).string() << "\"\n";
+			out << "#include \"" << get_relative_include_path(additional_host_include, source).string() << "\"\n";
+		}
+		out << "#include \"" << get_relative_include_path(host_header, source).string() << "\"\n";
+		out << "#include \"" << get_relative_include_path(api_header, source).string() << "\"\n";
+	};
+	if (FLAGS_host_shards < 2) {
+		outputs.emplace_back(std::async(std::launch::async, [&]() {
+			std::ostringstream out;
+			write_host_source_includes(out, host_source);
+			exp.export_host_cpp(out);
+			return write_output_file(host_source, out.str());
+		}));
+		outputs_written = remove_stale_host_shards(host_source, 0) && outputs_written;
+	} else {
+		std::size_t num_shards = FLAGS_host_shards;
+		outputs.emplace_back(std::async(std::launch::async, [&, num_shards]() {
+			std::ostringstream out;
+			write_host_source_includes(out, host_source);
+			exp.export_host_cpp_shard_init(out, num_shards);
+			return write_output_file(host_source, out.str());
+		}));
+		for (std::size_t i = 0; i < num_shards; ++i) {
+			outputs.emplace_back(std::async(std::launch::async, [&, i, num_shards]() {
+				std::filesystem::path shard_source = get_suffixed_path(host_source, std::to_string(i));
+				std::ostringstream out;
+				write_host_source_includes(out, shard_source);
+				exp.export_host_cpp_shard(out, exporter::host_shard(i, num_shards));
+				return write_output_file(shard_source, out.str());
+			}));
 		}
-		out << "#include \"" << get_relative_include_path(host_header, host_source).string() << "\"\n";
-		out << "#include \"" << get_relative_include_path(api_header, host_source).string() << "\"\n";
-		exp.export_host_cpp(out);
+		outputs_written = remove_stale_host_shards(host_source, num_shards) && outputs_written;
 	}
-	{
-		std::ofstream out(collect_source);
+	outputs.emplace_back(std::async(std::launch::async, [&]() {
+		std::ostringstream out;
 		if (!additional_host_include.empty()) {
 			out <<
 				"#include \"" <<
@@ -143,7 +590,36 @@ int main(int argc, char **argv) {
 				"\"\n";
 		}
 		exp.export_data_collection_cpp(out);
+		return write_output_file(collect_source, out.str());
+	}));
+	for (auto &output : outputs) {
+		outputs_written = output.get() && outputs_written;
+	}
+
+	// the ledgers are only updated once all outputs are in place, so that they never refer to names that no output
+	// file contains
+	if (!outputs_written) {
+		logger::get().log(
+			log_category::general, log_level::error, "not all output files were written; ledgers are left unchanged"
+		);
+		logger::get().flush();
+		return exit_output_error;
+	}
+	if (!ledger_path.empty()) {
+		std::ostringstream out;
+		ledger.save(out);
+		outputs_written = write_output_file(ledger_path, out.str());
+	}
+	if (!slot_ledger_path.empty()) {
+		std::ostringstream out;
+		slots.save(out);
+		outputs_written = write_output_file(slot_ledger_path, out.str()) && outputs_written;
+	}
+	if (!outputs_written) {
+		logger::get().flush();
+		return exit_output_error;
 	}
 
-	return 0;
+	logger::get().flush();
+	return status;
 }
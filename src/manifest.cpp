@@ -0,0 +1,700 @@
+#include "manifest.h"
+
+/// \file
+/// Implementation of the JSON and binary formats of \ref apigen::api_manifest.
+
+#include <algorithm>
+#include <array>
+#include <map>
+
+#include <fmt/format.h>
+
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_os_ostream.h>
+
+namespace apigen {
+	bool api_manifest::slot_info::has_same_signature(const slot_info &other) const {
+		if (
+			kind != other.kind || field != other.field ||
+			return_type != other.return_type || return_passing != other.return_passing ||
+			signature != other.signature || parameters.size() != other.parameters.size()
+		) {
+			return false;
+		}
+		for (std::size_t i = 0; i < parameters.size(); ++i) {
+			// parameter names are not part of the signature
+			const parameter_info &lhs = parameters[i], &rhs = other.parameters[i];
+			if (lhs.type != rhs.type || lhs.passing != rhs.passing) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	// json
+	/// Returns the name of the given \ref api_manifest::type_category.
+	[[nodiscard]] static llvm::StringRef _get_name(api_manifest::type_category cat) {
+		switch (cat) {
+		case api_manifest::type_category::builtin:
+			return "builtin";
+		case api_manifest::type_category::enumeration:
+			return "enum";
+		case api_manifest::type_category::record:
+			return "record";
+		case api_manifest::type_category::vector:
+			return "vector";
+		case api_manifest::type_category::array:
+			return "array";
+		case api_manifest::type_category::view:
+			return "view";
+		}
+		return "$BAD_CATEGORY";
+	}
+	/// Returns the name of the given \ref api_manifest::reference_kind.
+	[[nodiscard]] static llvm::StringRef _get_name(api_manifest::reference_kind ref) {
+		switch (ref) {
+		case api_manifest::reference_kind::none:
+			return "none";
+		case api_manifest::reference_kind::reference:
+			return "lvalue";
+		case api_manifest::reference_kind::rvalue_reference:
+			return "rvalue";
+		}
+		return "$BAD_REFERENCE";
+	}
+	/// Returns the name of the given \ref api_manifest::passing_mode.
+	[[nodiscard]] static llvm::StringRef _get_name(api_manifest::passing_mode mode) {
+		switch (mode) {
+		case api_manifest::passing_mode::value:
+			return "value";
+		case api_manifest::passing_mode::reference:
+			return "reference";
+		case api_manifest::passing_mode::moved:
+			return "moved";
+		case api_manifest::passing_mode::copied:
+			return "copied";
+		case api_manifest::passing_mode::output:
+			return "output";
+		}
+		return "$BAD_PASSING";
+	}
+	/// Returns the name of the given \ref api_manifest::slot_kind.
+	[[nodiscard]] static llvm::StringRef _get_name(api_manifest::slot_kind kind) {
+		switch (kind) {
+		case api_manifest::slot_kind::function:
+			return "function";
+		case api_manifest::slot_kind::destructor:
+			return "destructor";
+		case api_manifest::slot_kind::field_getter:
+			return "field_getter";
+		case api_manifest::slot_kind::field_const_getter:
+			return "field_const_getter";
+		case api_manifest::slot_kind::custom_function:
+			return "custom_function";
+		case api_manifest::slot_kind::table:
+			return "table";
+		case api_manifest::slot_kind::tombstone:
+			return "tombstone";
+		case api_manifest::slot_kind::field_copy_out:
+			return "field_copy_out";
+		case api_manifest::slot_kind::field_copy_in:
+			return "field_copy_in";
+		case api_manifest::slot_kind::record_snapshot:
+			return "record_snapshot";
+		case api_manifest::slot_kind::record_apply:
+			return "record_apply";
+		case api_manifest::slot_kind::function_batch:
+			return "function_batch";
+		}
+		return "$BAD_SLOT";
+	}
+	/// Returns the name of the given \ref api_manifest::field_kind.
+	[[nodiscard]] static llvm::StringRef _get_name(api_manifest::field_kind kind) {
+		switch (kind) {
+		case api_manifest::field_kind::none:
+			return "none";
+		case api_manifest::field_kind::normal:
+			return "normal";
+		case api_manifest::field_kind::reference:
+			return "reference";
+		case api_manifest::field_kind::constant:
+			return "const";
+		case api_manifest::field_kind::mutable_field:
+			return "mutable";
+		}
+		return "$BAD_FIELD";
+	}
+
+	/// Converts a \p std::string_view to a \p llvm::StringRef.
+	[[nodiscard]] inline static llvm::StringRef _to_string_ref(std::string_view str) {
+		return llvm::StringRef(str.data(), str.size());
+	}
+
+	/// Writes a \ref api_manifest::type_info as a JSON object.
+	static void _write_json_type(llvm::json::OStream &out, const api_manifest::type_info &type) {
+		out.object([&]() {
+			out.attribute("name", _to_string_ref(type.name));
+			out.attribute("category", _get_name(type.category));
+			out.attribute("reference", _get_name(type.reference));
+			out.attributeArray("qualifiers", [&]() {
+				for (std::uint8_t quals : type.qualifiers) {
+					out.array([&]() {
+						if (quals & api_manifest::const_qualifier) {
+							out.value("const");
+						}
+						if (quals & api_manifest::volatile_qualifier) {
+							out.value("volatile");
+						}
+					});
+				}
+			});
+		});
+	}
+
+	/// Writes an array of \ref api_manifest::field_info as the attribute with the given name.
+	static void _write_json_fields(
+		llvm::json::OStream &out, llvm::StringRef key, const std::vector<api_manifest::field_info> &fields
+	) {
+		out.attributeArray(key, [&]() {
+			for (const api_manifest::field_info &field : fields) {
+				out.object([&]() {
+					out.attribute("name", _to_string_ref(field.name));
+					out.attribute("declaration", _to_string_ref(field.declaration));
+					out.attribute("offset", static_cast<std::int64_t>(field.offset));
+				});
+			}
+		});
+	}
+
+	void api_manifest::write_json(std::ostream &stream) const {
+		llvm::raw_os_ostream raw_out(stream);
+		llvm::json::OStream out(raw_out, 1);
+		out.object([&]() {
+			out.attribute("version", static_cast<std::int64_t>(binary_version));
+			out.attributeArray("tables", [&]() {
+				for (const table_info &table : tables) {
+					out.object([&]() {
+						out.attribute("name", _to_string_ref(table.name));
+						out.attribute("group", _to_string_ref(table.group));
+						out.attributeArray("slots", [&]() {
+							for (const slot_info &slot : table.slots) {
+								out.object([&]() {
+									out.attribute("name", _to_string_ref(slot.name));
+									out.attribute("entity", _to_string_ref(slot.entity));
+									out.attribute("kind", _get_name(slot.kind));
+									if (slot.field != field_kind::none) {
+										out.attribute("field_kind", _get_name(slot.field));
+									}
+									if (slot.return_type) {
+										out.attributeBegin("return_type");
+										_write_json_type(out, slot.return_type.value());
+										out.attributeEnd();
+										out.attribute("return_passing", _get_name(slot.return_passing));
+									}
+									if (!slot.signature.empty()) {
+										out.attribute("signature", _to_string_ref(slot.signature));
+									}
+									out.attributeArray("parameters", [&]() {
+										for (const parameter_info &param : slot.parameters) {
+											out.object([&]() {
+												out.attribute("name", _to_string_ref(param.name));
+												out.attributeBegin("type");
+												_write_json_type(out, param.type);
+												out.attributeEnd();
+												out.attribute("passing", _get_name(param.passing));
+											});
+										}
+									});
+								});
+							}
+						});
+					});
+				}
+			});
+			out.attributeArray("records", [&]() {
+				for (const record_info &rec : records) {
+					out.object([&]() {
+						out.attribute("name", _to_string_ref(rec.name));
+						out.attribute("internal_name", _to_string_ref(rec.internal_name));
+						out.attribute("size", static_cast<std::int64_t>(rec.size));
+						out.attribute("alignment", static_cast<std::int64_t>(rec.alignment));
+						out.attribute("movable", rec.movable);
+						if (!rec.view_name.empty()) {
+							out.attributeObject("view", [&]() {
+								out.attribute("name", _to_string_ref(rec.view_name));
+								out.attribute("size", static_cast<std::int64_t>(rec.view_size));
+								_write_json_fields(out, "fields", rec.view_fields);
+							});
+						}
+						if (!rec.value_fields.empty()) {
+							_write_json_fields(out, "value_fields", rec.value_fields);
+						}
+						if (!rec.inline_fields.empty()) {
+							_write_json_fields(out, "inline_fields", rec.inline_fields);
+						}
+					});
+				}
+			});
+			out.attributeArray("enums", [&]() {
+				for (const enum_info &enumeration : enums) {
+					out.object([&]() {
+						out.attribute("name", _to_string_ref(enumeration.name));
+						out.attribute("internal_name", _to_string_ref(enumeration.internal_name));
+						out.attribute("underlying_type", _to_string_ref(enumeration.underlying_type));
+						out.attributeArray("enumerators", [&]() {
+							for (const enumerator_info &enumerator : enumeration.enumerators) {
+								out.object([&]() {
+									out.attribute("name", _to_string_ref(enumerator.name));
+									out.attribute("value", enumerator.value);
+								});
+							}
+						});
+					});
+				}
+			});
+		});
+		raw_out << "\n";
+	}
+
+
+	// binary
+	/// Builds the sections of the binary format.
+	class _binary_builder {
+	public:
+		/// Appends a string reference to the given section, adding the string to the string section.
+		void add_string(std::string &sec, std::string_view str) {
+			add_u32(sec, static_cast<std::uint32_t>(_strings.size()));
+			add_u32(sec, static_cast<std::uint32_t>(str.size()));
+			_strings += str;
+		}
+		/// Appends an unsigned 8-bit integer to the given section.
+		static void add_u8(std::string &sec, std::uint8_t value) {
+			sec.push_back(static_cast<char>(value));
+		}
+		/// Appends a little-endian unsigned 32-bit integer to the given section.
+		static void add_u32(std::string &sec, std::uint32_t value) {
+			for (std::size_t i = 0; i < 4; ++i) {
+				sec.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+			}
+		}
+		/// Appends a little-endian unsigned 64-bit integer to the given section.
+		static void add_u64(std::string &sec, std::uint64_t value) {
+			add_u32(sec, static_cast<std::uint32_t>(value & 0xFFFFFFFF));
+			add_u32(sec, static_cast<std::uint32_t>(value >> 32));
+		}
+		/// Appends a \ref api_manifest::type_info to the given section.
+		void add_type(std::string &sec, const api_manifest::type_info &type) {
+			add_string(sec, type.name);
+			add_u8(sec, static_cast<std::uint8_t>(type.category));
+			add_u8(sec, static_cast<std::uint8_t>(type.reference));
+			std::size_t levels = std::min(type.qualifiers.size(), api_manifest_view::max_qualifier_levels);
+			add_u8(sec, static_cast<std::uint8_t>(levels));
+			add_u8(sec, 0);
+			std::uint32_t quals = 0;
+			for (std::size_t i = 0; i < levels; ++i) {
+				quals |= static_cast<std::uint32_t>(type.qualifiers[i] & 3) << (i * 2);
+			}
+			add_u32(sec, quals);
+		}
+
+		/// Returns the section with the given index.
+		[[nodiscard]] std::string &get_section(api_manifest_view::section sec) {
+			return _sections[static_cast<std::size_t>(sec)];
+		}
+		/// Writes the header and all sections. The count of the string section is its size, and the corresponding
+		/// element of \p counts is ignored.
+		void write(std::ostream &out, std::array<std::uint32_t, 8> counts) {
+			counts[static_cast<std::size_t>(api_manifest_view::section::strings)] =
+				static_cast<std::uint32_t>(_strings.size());
+			get_section(api_manifest_view::section::strings) = std::move(_strings);
+			std::string header(api_manifest::binary_magic);
+			add_u32(header, api_manifest::binary_version);
+			add_u32(header, 0);
+			std::size_t offset = api_manifest_view::header_size;
+			for (std::size_t i = 0; i < _sections.size(); ++i) {
+				add_u32(header, static_cast<std::uint32_t>(offset));
+				add_u32(header, counts[i]);
+				offset += _sections[i].size();
+			}
+			out.write(header.data(), static_cast<std::streamsize>(header.size()));
+			for (const std::string &sec : _sections) {
+				out.write(sec.data(), static_cast<std::streamsize>(sec.size()));
+			}
+		}
+	protected:
+		std::string _strings; ///< The string section.
+		/// Contents of all sections.
+		std::array<std::string, static_cast<std::size_t>(api_manifest_view::section::max_value)> _sections;
+	};
+
+	void api_manifest::write_binary(std::ostream &out) const {
+		using section = api_manifest_view::section;
+
+		_binary_builder builder;
+		std::string
+			&table_sec = builder.get_section(section::tables),
+			&slot_sec = builder.get_section(section::slots),
+			&param_sec = builder.get_section(section::parameters),
+			&record_sec = builder.get_section(section::records),
+			&enum_sec = builder.get_section(section::enums),
+			&enumerator_sec = builder.get_section(section::enumerators),
+			&field_sec = builder.get_section(section::fields);
+		std::uint32_t num_slots = 0, num_params = 0, num_enumerators = 0, num_fields = 0;
+		// adds the given fields to the field section and refers to them from the given section
+		auto add_fields = [&](std::string &sec, const std::vector<field_info> &fields) {
+			_binary_builder::add_u32(sec, num_fields);
+			_binary_builder::add_u32(sec, static_cast<std::uint32_t>(fields.size()));
+			for (const field_info &field : fields) {
+				builder.add_string(field_sec, field.name);
+				builder.add_string(field_sec, field.declaration);
+				_binary_builder::add_u64(field_sec, field.offset);
+			}
+			num_fields += static_cast<std::uint32_t>(fields.size());
+		};
+		for (const table_info &table : tables) {
+			builder.add_string(table_sec, table.name);
+			builder.add_string(table_sec, table.group);
+			_binary_builder::add_u32(table_sec, num_slots);
+			_binary_builder::add_u32(table_sec, static_cast<std::uint32_t>(table.slots.size()));
+			for (const slot_info &slot : table.slots) {
+				builder.add_string(slot_sec, slot.name);
+				builder.add_string(slot_sec, slot.entity);
+				_binary_builder::add_u8(slot_sec, static_cast<std::uint8_t>(slot.kind));
+				_binary_builder::add_u8(slot_sec, static_cast<std::uint8_t>(slot.field));
+				_binary_builder::add_u8(slot_sec, static_cast<std::uint8_t>(slot.return_passing));
+				_binary_builder::add_u8(slot_sec, slot.return_type.has_value() ? 1 : 0);
+				builder.add_type(slot_sec, slot.return_type.value_or(type_info()));
+				_binary_builder::add_u32(slot_sec, num_params);
+				_binary_builder::add_u32(slot_sec, static_cast<std::uint32_t>(slot.parameters.size()));
+				_binary_builder::add_u32(slot_sec, 0);
+				builder.add_string(slot_sec, slot.signature);
+				for (const parameter_info &param : slot.parameters) {
+					builder.add_string(param_sec, param.name);
+					builder.add_type(param_sec, param.type);
+					_binary_builder::add_u8(param_sec, static_cast<std::uint8_t>(param.passing));
+					param_sec.append(7, '\0');
+				}
+				num_params += static_cast<std::uint32_t>(slot.parameters.size());
+			}
+			num_slots += static_cast<std::uint32_t>(table.slots.size());
+		}
+		for (const record_info &rec : records) {
+			builder.add_string(record_sec, rec.name);
+			builder.add_string(record_sec, rec.internal_name);
+			_binary_builder::add_u64(record_sec, rec.size);
+			_binary_builder::add_u64(record_sec, rec.alignment);
+			_binary_builder::add_u32(record_sec, rec.movable ? 1 : 0);
+			_binary_builder::add_u32(record_sec, 0);
+			builder.add_string(record_sec, rec.view_name);
+			_binary_builder::add_u64(record_sec, rec.view_size);
+			add_fields(record_sec, rec.view_fields);
+			add_fields(record_sec, rec.value_fields);
+			add_fields(record_sec, rec.inline_fields);
+		}
+		for (const enum_info &enumeration : enums) {
+			builder.add_string(enum_sec, enumeration.name);
+			builder.add_string(enum_sec, enumeration.internal_name);
+			builder.add_string(enum_sec, enumeration.underlying_type);
+			_binary_builder::add_u32(enum_sec, num_enumerators);
+			_binary_builder::add_u32(enum_sec, static_cast<std::uint32_t>(enumeration.enumerators.size()));
+			for (const enumerator_info &enumerator : enumeration.enumerators) {
+				builder.add_string(enumerator_sec, enumerator.name);
+				_binary_builder::add_u64(enumerator_sec, static_cast<std::uint64_t>(enumerator.value));
+			}
+			num_enumerators += static_cast<std::uint32_t>(enumeration.enumerators.size());
+		}
+
+		builder.write(out, {
+			0, // computed by the builder
+			static_cast<std::uint32_t>(tables.size()), num_slots, num_params,
+			static_cast<std::uint32_t>(records.size()), static_cast<std::uint32_t>(enums.size()), num_enumerators,
+			num_fields
+		});
+	}
+
+	/// Reads a \ref api_manifest::type_info at the given offset.
+	[[nodiscard]] static api_manifest::type_info _read_type(const api_manifest_view &view, std::size_t offset) {
+		api_manifest::type_info result;
+		result.name = std::string(view.read_string(offset));
+		result.category = static_cast<api_manifest::type_category>(view.read_u8(offset + 8));
+		result.reference = static_cast<api_manifest::reference_kind>(view.read_u8(offset + 9));
+		std::size_t levels = std::min<std::size_t>(view.read_u8(offset + 10), api_manifest_view::max_qualifier_levels);
+		std::uint32_t quals = view.read_u32(offset + 12);
+		for (std::size_t i = 0; i < levels; ++i) {
+			result.qualifiers.emplace_back(static_cast<std::uint8_t>((quals >> (i * 2)) & 3));
+		}
+		return result;
+	}
+
+	std::optional<api_manifest> api_manifest::read_binary(std::string_view data) {
+		using section = api_manifest_view::section;
+
+		std::optional<api_manifest_view> view = api_manifest_view::open(data);
+		if (!view) {
+			return std::nullopt;
+		}
+		// checks that the given range lies within the given section
+		auto in_range = [&](section sec, std::uint64_t first, std::uint64_t count) {
+			return first + count <= view->get_count(sec);
+		};
+		// reads the range of fields referenced at the given offset, returning false if it's out of bounds
+		auto read_fields = [&](std::size_t offset, std::vector<field_info> &fields) {
+			std::uint32_t first = view->read_u32(offset), count = view->read_u32(offset + 4);
+			if (!in_range(section::fields, first, count)) {
+				return false;
+			}
+			for (std::size_t i = first; i < first + count; ++i) {
+				std::size_t field_offset = view->get_entry_offset(section::fields, i, api_manifest_view::field_size);
+				field_info &field = fields.emplace_back();
+				field.name = std::string(view->read_string(field_offset));
+				field.declaration = std::string(view->read_string(field_offset + 8));
+				field.offset = view->read_u64(field_offset + 16);
+			}
+			return true;
+		};
+
+		api_manifest result;
+		for (std::size_t i = 0; i < view->get_count(section::tables); ++i) {
+			std::size_t table_offset = view->get_entry_offset(section::tables, i, api_manifest_view::table_size);
+			table_info &table = result.tables.emplace_back();
+			table.name = std::string(view->read_string(table_offset));
+			table.group = std::string(view->read_string(table_offset + 8));
+			std::uint32_t
+				first_slot = view->read_u32(table_offset + 16),
+				slot_count = view->read_u32(table_offset + 20);
+			if (!in_range(section::slots, first_slot, slot_count)) {
+				return std::nullopt;
+			}
+			for (std::size_t j = first_slot; j < first_slot + slot_count; ++j) {
+				std::size_t slot_offset = view->get_entry_offset(section::slots, j, api_manifest_view::slot_size);
+				slot_info &slot = table.slots.emplace_back();
+				slot.name = std::string(view->read_string(slot_offset));
+				slot.entity = std::string(view->read_string(slot_offset + 8));
+				slot.kind = static_cast<slot_kind>(view->read_u8(slot_offset + 16));
+				slot.field = static_cast<field_kind>(view->read_u8(slot_offset + 17));
+				slot.return_passing = static_cast<passing_mode>(view->read_u8(slot_offset + 18));
+				if (view->read_u8(slot_offset + 19) != 0) {
+					slot.return_type = _read_type(view.value(), slot_offset + 20);
+				}
+				std::uint32_t
+					first_param = view->read_u32(slot_offset + 36),
+					param_count = view->read_u32(slot_offset + 40);
+				slot.signature = std::string(view->read_string(slot_offset + 48));
+				if (!in_range(section::parameters, first_param, param_count)) {
+					return std::nullopt;
+				}
+				for (std::size_t k = first_param; k < first_param + param_count; ++k) {
+					std::size_t param_offset =
+						view->get_entry_offset(section::parameters, k, api_manifest_view::parameter_size);
+					parameter_info &param = slot.parameters.emplace_back();
+					param.name = std::string(view->read_string(param_offset));
+					param.type = _read_type(view.value(), param_offset + 8);
+					param.passing = static_cast<passing_mode>(view->read_u8(param_offset + 24));
+				}
+			}
+		}
+		for (std::size_t i = 0; i < view->get_count(section::records); ++i) {
+			std::size_t offset = view->get_entry_offset(section::records, i, api_manifest_view::record_size);
+			record_info &rec = result.records.emplace_back();
+			rec.name = std::string(view->read_string(offset));
+			rec.internal_name = std::string(view->read_string(offset + 8));
+			rec.size = view->read_u64(offset + 16);
+			rec.alignment = view->read_u64(offset + 24);
+			rec.movable = (view->read_u32(offset + 32) & 1) != 0;
+			rec.view_name = std::string(view->read_string(offset + 40));
+			rec.view_size = view->read_u64(offset + 48);
+			if (
+				!read_fields(offset + 56, rec.view_fields) || !read_fields(offset + 64, rec.value_fields) ||
+				!read_fields(offset + 72, rec.inline_fields)
+			) {
+				return std::nullopt;
+			}
+		}
+		for (std::size_t i = 0; i < view->get_count(section::enums); ++i) {
+			std::size_t offset = view->get_entry_offset(section::enums, i, api_manifest_view::enum_size);
+			enum_info &enumeration = result.enums.emplace_back();
+			enumeration.name = std::string(view->read_string(offset));
+			enumeration.internal_name = std::string(view->read_string(offset + 8));
+			enumeration.underlying_type = std::string(view->read_string(offset + 16));
+			std::uint32_t first = view->read_u32(offset + 24), count = view->read_u32(offset + 28);
+			if (!in_range(section::enumerators, first, count)) {
+				return std::nullopt;
+			}
+			for (std::size_t j = first; j < first + count; ++j) {
+				std::size_t enumerator_offset =
+					view->get_entry_offset(section::enumerators, j, api_manifest_view::enumerator_size);
+				enumerator_info &enumerator = enumeration.enumerators.emplace_back();
+				enumerator.name = std::string(view->read_string(enumerator_offset));
+				enumerator.value = static_cast<std::int64_t>(view->read_u64(enumerator_offset + 8));
+			}
+		}
+		return result;
+	}
+
+
+	// comparison
+	/// Returns a map from the names of the given elements to the elements.
+	template <typename T> [[nodiscard]] static std::map<std::string_view, const T*> _index_by_name(
+		const std::vector<T> &elements
+	) {
+		std::map<std::string_view, const T*> result;
+		for (const T &elem : elements) {
+			result.emplace(elem.name, &elem);
+		}
+		return result;
+	}
+
+	/// Compares the slots of two versions of the same table.
+	static void _compare_tables(
+		api_manifest_diff &diff, const api_manifest::table_info &previous, const api_manifest::table_info &current
+	) {
+		std::size_t common = std::min(previous.slots.size(), current.slots.size());
+		for (std::size_t i = 0; i < common; ++i) {
+			const api_manifest::slot_info &prev_slot = previous.slots[i], &cur_slot = current.slots[i];
+			if (prev_slot.name != cur_slot.name) {
+				diff.add_breakage(fmt::format(
+					"{}: slot {} changed from {} to {}", current.name, i, prev_slot.name, cur_slot.name
+				));
+			} else if (!prev_slot.has_same_signature(cur_slot)) {
+				diff.add_breakage(fmt::format("{}: signature of {} changed", current.name, cur_slot.name));
+			}
+		}
+		for (std::size_t i = common; i < previous.slots.size(); ++i) {
+			diff.add_breakage(fmt::format("{}: slot {} removed", previous.name, previous.slots[i].name));
+		}
+		for (std::size_t i = common; i < current.slots.size(); ++i) {
+			// sub-tables are embedded by value, so growing one moves everything after it in the root table
+			std::string desc = fmt::format("{}: slot {} appended", current.name, current.slots[i].name);
+			if (current.group.empty()) {
+				diff.add_addition(std::move(desc));
+			} else {
+				diff.add_breakage(std::move(desc));
+			}
+		}
+	}
+
+	/// Compares the fields with inline accessors of two versions of the same record.
+	static void _compare_inline_fields(
+		api_manifest_diff &diff, const api_manifest::record_info &previous, const api_manifest::record_info &current
+	) {
+		auto current_fields = _index_by_name(current.inline_fields);
+		for (const api_manifest::field_info &prev_field : previous.inline_fields) {
+			auto it = current_fields.find(prev_field.name);
+			if (it == current_fields.end()) {
+				diff.add_breakage(fmt::format("inline accessors of {}::{} removed", previous.name, prev_field.name));
+				continue;
+			}
+			if (it->second->offset != prev_field.offset) {
+				diff.add_breakage(fmt::format(
+					"offset of {}::{} changed from {} to {}",
+					previous.name, prev_field.name, prev_field.offset, it->second->offset
+				));
+			}
+			current_fields.erase(it);
+		}
+		for (auto &&[name, field] : current_fields) {
+			diff.add_addition(fmt::format("inline accessors of {}::{} added", current.name, name));
+		}
+	}
+
+	api_manifest_diff api_manifest_diff::compare(const api_manifest &previous, const api_manifest &current) {
+		api_manifest_diff result;
+
+		auto current_tables = _index_by_name(current.tables);
+		for (const api_manifest::table_info &prev_table : previous.tables) {
+			if (auto it = current_tables.find(prev_table.name); it != current_tables.end()) {
+				_compare_tables(result, prev_table, *it->second);
+				current_tables.erase(it);
+			} else {
+				result.add_breakage(fmt::format("table {} removed", prev_table.name));
+			}
+		}
+		for (auto &&[name, table] : current_tables) {
+			// new sub-tables are also new members of the root table, which is checked above
+			result.add_addition(fmt::format("table {} added", name));
+		}
+
+		auto current_records = _index_by_name(current.records);
+		for (const api_manifest::record_info &prev_rec : previous.records) {
+			auto it = current_records.find(prev_rec.name);
+			if (it == current_records.end()) {
+				result.add_breakage(fmt::format("record {} removed", prev_rec.name));
+				continue;
+			}
+			const api_manifest::record_info &cur_rec = *it->second;
+			if (prev_rec.size != cur_rec.size || prev_rec.alignment != cur_rec.alignment) {
+				result.add_breakage(fmt::format(
+					"layout of record {} changed from {}/{} to {}/{} (size/alignment)", prev_rec.name,
+					prev_rec.size, prev_rec.alignment, cur_rec.size, cur_rec.alignment
+				));
+			}
+			if (prev_rec.movable != cur_rec.movable) {
+				result.add_breakage(fmt::format("record {} changed between being moved and copied", prev_rec.name));
+			}
+			if (prev_rec.value_fields != cur_rec.value_fields) {
+				result.add_breakage(fmt::format("fields of record {} passed by value changed", prev_rec.name));
+			}
+			_compare_inline_fields(result, prev_rec, cur_rec);
+			// clients allocate views themselves, so any change to their layout breaks them
+			if (!prev_rec.view_name.empty()) {
+				if (cur_rec.view_name.empty()) {
+					result.add_breakage(fmt::format("view of record {} removed", prev_rec.name));
+				} else if (
+					prev_rec.view_name != cur_rec.view_name || prev_rec.view_size != cur_rec.view_size ||
+					prev_rec.view_fields != cur_rec.view_fields
+				) {
+					result.add_breakage(fmt::format(
+						"layout of view {} of record {} changed", prev_rec.view_name, prev_rec.name
+					));
+				}
+			} else if (!cur_rec.view_name.empty()) {
+				result.add_addition(fmt::format("view of record {} added", cur_rec.name));
+			}
+			current_records.erase(it);
+		}
+		for (auto &&[name, rec] : current_records) {
+			result.add_addition(fmt::format("record {} added", name));
+		}
+
+		auto current_enums = _index_by_name(current.enums);
+		for (const api_manifest::enum_info &prev_enum : previous.enums) {
+			auto it = current_enums.find(prev_enum.name);
+			if (it == current_enums.end()) {
+				result.add_breakage(fmt::format("enum {} removed", prev_enum.name));
+				continue;
+			}
+			const api_manifest::enum_info &cur_enum = *it->second;
+			if (prev_enum.underlying_type != cur_enum.underlying_type) {
+				result.add_breakage(fmt::format(
+					"underlying type of enum {} changed from {} to {}",
+					prev_enum.name, prev_enum.underlying_type, cur_enum.underlying_type
+				));
+			}
+			auto current_enumerators = _index_by_name(cur_enum.enumerators);
+			for (const api_manifest::enumerator_info &prev_enumerator : prev_enum.enumerators) {
+				auto enumerator_it = current_enumerators.find(prev_enumerator.name);
+				if (enumerator_it == current_enumerators.end()) {
+					result.add_breakage(fmt::format("enumerator {} removed", prev_enumerator.name));
+					continue;
+				}
+				if (enumerator_it->second->value != prev_enumerator.value) {
+					result.add_breakage(fmt::format(
+						"value of enumerator {} changed from {} to {}",
+						prev_enumerator.name, prev_enumerator.value, enumerator_it->second->value
+					));
+				}
+				current_enumerators.erase(enumerator_it);
+			}
+			for (auto &&[name, enumerator] : current_enumerators) {
+				result.add_addition(fmt::format("enumerator {} added", name));
+			}
+			current_enums.erase(it);
+		}
+		for (auto &&[name, enumeration] : current_enums) {
+			result.add_addition(fmt::format("enum {} added", name));
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+/// \file
+/// A machine-readable description of the generated API, and its JSON and binary representations.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace apigen {
+	/// Describes every slot of the API tables, and all exported records and enums. The numeric values of all enums
+	/// in this struct are part of the binary format and must not be changed.
+	struct api_manifest {
+		/// The version of the binary format.
+		constexpr static std::uint32_t binary_version = 4;
+		/// The magic number at the start of the binary format.
+		constexpr static std::string_view binary_magic{"APIGENMF", 8};
+
+		/// The category of a type.
+		enum class type_category : std::uint8_t {
+			builtin = 0, ///< A builtin type, including \p void.
+			enumeration = 1, ///< An exported enum.
+			record = 2, ///< An exported record.
+			vector = 3, ///< A SIMD vector type, exported as a typedef.
+			array = 4, ///< A fixed-size array type, exported as a typedef.
+			view = 5 ///< The view struct of a record that holds copies of its fields.
+		};
+		/// The kind of reference of a type.
+		enum class reference_kind : std::uint8_t {
+			none = 0, ///< Not a reference.
+			reference = 1, ///< An lvalue reference.
+			rvalue_reference = 2 ///< An rvalue reference.
+		};
+		/// Qualifier bits of a single level of a type.
+		enum qualifier_bits : std::uint8_t {
+			const_qualifier = 1, ///< The \p const qualifier.
+			volatile_qualifier = 2 ///< The \p volatile qualifier.
+		};
+		/// How a value is passed between the client and the host.
+		enum class passing_mode : std::uint8_t {
+			value = 0, ///< Passed by value.
+			reference = 1, ///< Passed as a pointer, either because it's a pointer or a reference.
+			moved = 2, ///< A record passed as a pointer and moved from.
+			copied = 3, ///< A record passed as a pointer and copied.
+			output = 4 ///< A record returned by constructing it in memory provided by the caller.
+		};
+		/// The kind of an API table slot.
+		enum class slot_kind : std::uint8_t {
+			function = 0, ///< A function, method, or constructor.
+			destructor = 1, ///< The destructor of a record.
+			field_getter = 2, ///< The non-const getter of a field.
+			field_const_getter = 3, ///< The const getter of a field.
+			custom_function = 4, ///< A custom function whose signature is only described by its rendered type.
+			table = 5, ///< A sub-table.
+			tombstone = 6, ///< A placeholder for a removed slot that keeps the offsets of the following slots.
+			field_copy_out = 7, ///< The function that copies an array field out of an object.
+			field_copy_in = 8, ///< The function that copies an array field into an object.
+			record_snapshot = 9, ///< The function that copies fields of a record into its view.
+			record_apply = 10, ///< The function that writes selected fields of a view back into a record.
+			function_batch = 11 ///< The batch variant of a function that takes arrays of arguments.
+		};
+		/// The kind of a field, for field getter slots.
+		enum class field_kind : std::uint8_t {
+			none = 0, ///< Not a field getter.
+			normal = 1, ///< A normal field.
+			reference = 2, ///< A reference field.
+			constant = 3, ///< A const field.
+			mutable_field = 4 ///< A mutable field.
+		};
+
+		/// A type.
+		struct type_info {
+			std::string name; ///< The name of the type in the API header, without qualifiers.
+			type_category category = type_category::builtin; ///< The category of this type.
+			reference_kind reference = reference_kind::none; ///< The reference kind.
+			/// Qualifiers of each level of this type, outermost first. There's one level per pointer, plus the
+			/// pointee.
+			std::vector<std::uint8_t> qualifiers;
+
+			/// Compares all members.
+			friend bool operator==(const type_info &lhs, const type_info &rhs) {
+				return
+					lhs.name == rhs.name && lhs.category == rhs.category && lhs.reference == rhs.reference &&
+					lhs.qualifiers == rhs.qualifiers;
+			}
+			/// Compares all members.
+			friend bool operator!=(const type_info &lhs, const type_info &rhs) {
+				return !(lhs == rhs);
+			}
+		};
+		/// A parameter of a function.
+		struct parameter_info {
+			std::string name; ///< The name of the parameter.
+			type_info type; ///< The type of the parameter.
+			passing_mode passing = passing_mode::value; ///< How this parameter is passed.
+		};
+		/// A slot in an API table.
+		struct slot_info {
+			std::string name; ///< The name of the slot.
+			/// The fully qualified name of the entity in the host, the sub-table type, or the former name of a tombstone.
+			std::string entity;
+			slot_kind kind = slot_kind::function; ///< The kind of this slot.
+			field_kind field = field_kind::none; ///< The kind of the field for getter slots.
+			std::optional<type_info> return_type; ///< The return type, or empty if the slot returns \p void.
+			passing_mode return_passing = passing_mode::value; ///< How the return value is passed.
+			std::vector<parameter_info> parameters; ///< The parameters.
+			/// The type of the function pointer as written in the API header, e.g., <cc>foo *(*)(bar*)</cc>, for
+			/// custom functions, whose parameters and return types are not described otherwise. Empty for all other
+			/// slots.
+			std::string signature;
+
+			/// Returns whether the signature of this slot is the same as that of the other slot.
+			[[nodiscard]] bool has_same_signature(const slot_info &other) const;
+		};
+		/// An API table.
+		struct table_info {
+			std::string name; ///< The name of the table struct.
+			std::string group; ///< The group of this table, or an empty string for the root table.
+			std::vector<slot_info> slots; ///< Slots in the order of their declarations.
+		};
+		/// A field of a struct whose layout clients depend on.
+		struct field_info {
+			std::string name; ///< The name of the field.
+			/// The declaration of the field in the API header, including its name. This is empty for fields with
+			/// inline accessors, whose types are described by the corresponding getter slots.
+			std::string declaration;
+			std::uint64_t offset = 0; ///< The offset of the field in bytes.
+
+			/// Compares all members.
+			friend bool operator==(const field_info &lhs, const field_info &rhs) {
+				return lhs.name == rhs.name && lhs.declaration == rhs.declaration && lhs.offset == rhs.offset;
+			}
+			/// Compares all members.
+			friend bool operator!=(const field_info &lhs, const field_info &rhs) {
+				return !(lhs == rhs);
+			}
+		};
+		/// An exported record.
+		struct record_info {
+			std::string name; ///< The name in the API header.
+			std::string internal_name; ///< The fully qualified name in the host.
+			std::uint64_t size = 0; ///< The size of the record in bytes, or zero if it's unknown.
+			std::uint64_t alignment = 0; ///< The alignment of the record in bytes, or zero if it's unknown.
+			bool movable = false; ///< Whether this record has a move constructor.
+			std::string view_name; ///< The name of the view struct, or an empty string if the record has no view.
+			std::uint64_t view_size = 0; ///< The size of the view struct in bytes.
+			std::vector<field_info> view_fields; ///< The fields of the view struct in declaration order.
+			/// The fields of the record in declaration order if its layout is mirrored in the API header so that it
+			/// can be passed by value, or empty if it's opaque.
+			std::vector<field_info> value_fields;
+			/// The fields that have inline accessors in the API header, in declaration order. Their offsets are
+			/// compiled into clients.
+			std::vector<field_info> inline_fields;
+		};
+		/// An enumerator.
+		struct enumerator_info {
+			std::string name; ///< The name in the API header.
+			std::int64_t value = 0; ///< The value.
+		};
+		/// An exported enum.
+		struct enum_info {
+			std::string name; ///< The name in the API header.
+			std::string internal_name; ///< The fully qualified name in the host.
+			std::string underlying_type; ///< The underlying integer type.
+			std::vector<enumerator_info> enumerators; ///< All enumerators.
+		};
+
+		std::vector<table_info> tables; ///< All API tables, with the root table first.
+		std::vector<record_info> records; ///< All exported records.
+		std::vector<enum_info> enums; ///< All exported enums.
+
+		/// Writes this manifest as a JSON document.
+		void write_json(std::ostream&) const;
+		/// Writes this manifest in the binary format. See \ref api_manifest_view for the layout.
+		void write_binary(std::ostream&) const;
+		/// Reads a manifest from data in the binary format. Returns \p std::nullopt if the data is malformed.
+		[[nodiscard]] static std::optional<api_manifest> read_binary(std::string_view);
+	};
+
+	/// How the API changed between two generations, in increasing order of severity.
+	enum class abi_change : unsigned char {
+		none, ///< Nothing that clients can observe has changed.
+		additive, ///< Slots, records, enums, or enumerators were added without affecting existing ones.
+		breaking ///< Existing slots were removed, reordered, or changed, or record layouts changed.
+	};
+	/// The differences between two \ref api_manifest instances.
+	struct api_manifest_diff {
+		abi_change change = abi_change::none; ///< The most severe change.
+		std::vector<std::string> additions; ///< Descriptions of all additive changes.
+		std::vector<std::string> breakages; ///< Descriptions of all breaking changes.
+
+		/// Records an additive change.
+		void add_addition(std::string desc) {
+			change = std::max(change, abi_change::additive);
+			additions.emplace_back(std::move(desc));
+		}
+		/// Records a breaking change.
+		void add_breakage(std::string desc) {
+			change = abi_change::breaking;
+			breakages.emplace_back(std::move(desc));
+		}
+
+		/// Compares the manifest of a previous generation against that of the current one. Slots may only be
+		/// appended to the root table; since sub-tables are embedded in the root table, appending to them is a
+		/// breaking change.
+		[[nodiscard]] static api_manifest_diff compare(const api_manifest &previous, const api_manifest &current);
+	};
+
+	/// Provides read-only access to a manifest in the binary format without copying or parsing it, e.g., from a
+	/// memory-mapped file. All integers are little-endian. The data begins with a header:
+	///
+	/// <pre>
+	/// char magic[8]; u32 version; u32 reserved;
+	/// section strings, tables, slots, parameters, records, enums, enumerators, fields; // { u32 offset; u32 count; }
+	/// </pre>
+	///
+	/// Offsets are relative to the start of the data. The string section contains raw characters, and its count is
+	/// in bytes; strings are referenced by <cc>{ u32 offset; u32 length; }</cc> relative to the section. All other
+	/// sections are arrays of fixed-size entries whose layouts are given by the \p *_size constants and the
+	/// accessors below. Entries refer to ranges of other sections by their first index and count.
+	class api_manifest_view {
+	public:
+		constexpr static std::size_t
+			header_size = 80, ///< The size of the header.
+			string_ref_size = 8, ///< <cc>{ u32 offset; u32 length; }</cc>
+			/// <cc>{ string name; u8 category, reference, qualifier_count, reserved; u32 qualifiers; }</cc> with
+			/// two qualifier bits for each level.
+			type_size = 16,
+			/// <cc>{ string name, group; u32 first_slot, slot_count; }</cc>
+			table_size = 24,
+			/// <cc>{ string name, entity; u8 kind, field_kind, return_passing, has_return; type return_type;
+			/// u32 first_parameter, parameter_count, reserved; string signature; }</cc>
+			slot_size = 56,
+			/// <cc>{ string name; type type; u8 passing, reserved[7]; }</cc>
+			parameter_size = 32,
+			/// <cc>{ string name, internal_name; u64 size, alignment; u32 flags, reserved; string view_name;
+			/// u64 view_size; u32 first_view_field, view_field_count, first_value_field, value_field_count,
+			/// first_inline_field, inline_field_count; }</cc>
+			record_size = 80,
+			/// <cc>{ string name, internal_name, underlying_type; u32 first_enumerator, enumerator_count; }</cc>
+			enum_size = 32,
+			/// <cc>{ string name; i64 value; }</cc>
+			enumerator_size = 16,
+			/// <cc>{ string name, declaration; u64 offset; }</cc>
+			field_size = 24;
+		/// The maximum number of qualifier levels that can be stored for a type.
+		constexpr static std::size_t max_qualifier_levels = 16;
+
+		/// The sections of the binary format, in the order they appear in the header.
+		enum class section : std::size_t {
+			strings, ///< The string section.
+			tables, ///< The table section.
+			slots, ///< The slot section.
+			parameters, ///< The parameter section.
+			records, ///< The record section.
+			enums, ///< The enum section.
+			enumerators, ///< The enumerator section.
+			fields, ///< The field section.
+
+			max_value ///< The number of sections.
+		};
+
+		/// Returns the version of the binary format that the given data is written in, or \p std::nullopt if the
+		/// data doesn't start with the magic number and the version. This works for all versions of the format, so
+		/// that data written by another version of this program can be told apart from malformed data.
+		[[nodiscard]] static std::optional<std::uint32_t> get_version(std::string_view data) {
+			if (data.size() < 12 || data.substr(0, 8) != api_manifest::binary_magic) {
+				return std::nullopt;
+			}
+			return api_manifest_view(data)._u32(8);
+		}
+		/// Validates the header and the bounds of all sections, and returns a view of the data if it's valid. Data in
+		/// other versions of the binary format is rejected.
+		[[nodiscard]] static std::optional<api_manifest_view> open(std::string_view data) {
+			if (data.size() < header_size || data.substr(0, 8) != api_manifest::binary_magic) {
+				return std::nullopt;
+			}
+			api_manifest_view result(data);
+			if (result._u32(8) != api_manifest::binary_version) {
+				return std::nullopt;
+			}
+			constexpr std::size_t entry_sizes[] = {
+				1, table_size, slot_size, parameter_size, record_size, enum_size, enumerator_size, field_size
+			};
+			for (std::size_t i = 0; i < static_cast<std::size_t>(section::max_value); ++i) {
+				auto sec = static_cast<section>(i);
+				std::uint64_t end =
+					static_cast<std::uint64_t>(result.get_offset(sec)) +
+					static_cast<std::uint64_t>(result.get_count(sec)) * entry_sizes[i];
+				if (end > data.size()) {
+					return std::nullopt;
+				}
+			}
+			return result;
+		}
+
+		/// Returns the offset of the given section.
+		[[nodiscard]] std::uint32_t get_offset(section sec) const {
+			return _u32(16 + static_cast<std::size_t>(sec) * 8);
+		}
+		/// Returns the number of entries in the given section.
+		[[nodiscard]] std::uint32_t get_count(section sec) const {
+			return _u32(20 + static_cast<std::size_t>(sec) * 8);
+		}
+		/// Returns the offset of the entry with the given index in the given section.
+		[[nodiscard]] std::size_t get_entry_offset(section sec, std::size_t index, std::size_t entry_size) const {
+			return get_offset(sec) + index * entry_size;
+		}
+
+		/// Reads a string reference at the given offset. Returns an empty string if it's out of bounds.
+		[[nodiscard]] std::string_view read_string(std::size_t offset) const {
+			std::uint64_t begin = _u32(offset), length = _u32(offset + 4);
+			if (begin + length > get_count(section::strings)) {
+				return std::string_view();
+			}
+			return _data.substr(get_offset(section::strings) + begin, length);
+		}
+		/// Reads an unsigned 8-bit integer at the given offset.
+		[[nodiscard]] std::uint8_t read_u8(std::size_t offset) const {
+			return static_cast<std::uint8_t>(_data[offset]);
+		}
+		/// Reads an unsigned 32-bit integer at the given offset.
+		[[nodiscard]] std::uint32_t read_u32(std::size_t offset) const {
+			return _u32(offset);
+		}
+		/// Reads an unsigned 64-bit integer at the given offset.
+		[[nodiscard]] std::uint64_t read_u64(std::size_t offset) const {
+			return static_cast<std::uint64_t>(_u32(offset)) | (static_cast<std::uint64_t>(_u32(offset + 4)) << 32);
+		}
+
+		/// Returns the name of the table with the given index.
+		[[nodiscard]] std::string_view get_table_name(std::size_t i) const {
+			return read_string(get_entry_offset(section::tables, i, table_size));
+		}
+		/// Returns the name of the slot with the given index.
+		[[nodiscard]] std::string_view get_slot_name(std::size_t i) const {
+			return read_string(get_entry_offset(section::slots, i, slot_size));
+		}
+		/// Returns the kind of the slot with the given index.
+		[[nodiscard]] api_manifest::slot_kind get_slot_kind(std::size_t i) const {
+			return static_cast<api_manifest::slot_kind>(read_u8(get_entry_offset(section::slots, i, slot_size) + 16));
+		}
+		/// Returns the name of the record with the given index.
+		[[nodiscard]] std::string_view get_record_name(std::size_t i) const {
+			return read_string(get_entry_offset(section::records, i, record_size));
+		}
+		/// Returns the size of the record with the given index.
+		[[nodiscard]] std::uint64_t get_record_size(std::size_t i) const {
+			return read_u64(get_entry_offset(section::records, i, record_size) + 16);
+		}
+		/// Returns the alignment of the record with the given index.
+		[[nodiscard]] std::uint64_t get_record_alignment(std::size_t i) const {
+			return read_u64(get_entry_offset(section::records, i, record_size) + 24);
+		}
+	protected:
+		/// Initializes \ref _data.
+		explicit api_manifest_view(std::string_view data) : _data(data) {
+		}
+
+		/// Reads a little-endian unsigned 32-bit integer.
+		[[nodiscard]] std::uint32_t _u32(std::size_t offset) const {
+			unsigned char bytes[4];
+			std::memcpy(bytes, _data.data() + offset, 4);
+			return
+				static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8) |
+				(static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+		}
+
+		std::string_view _data; ///< The data.
+	};
+}
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
 namespace apigen {
 	/// Marks whether bitwise operators are enabled for a particular enum class type. Specialize this type to enable
@@ -81,6 +86,92 @@ namespace apigen {
 		return std::string_view(str.data(), str.size());
 	}
 
+	/// Computes the 64-bit FNV-1a hash of the given string. Unlike \p std::hash, the result is the same across runs,
+	/// platforms, and standard library implementations.
+	[[nodiscard]] inline std::uint64_t stable_hash(std::string_view str) {
+		std::uint64_t result = 0xcbf29ce484222325ull;
+		for (char c : str) {
+			result ^= static_cast<unsigned char>(c);
+			result *= 0x100000001b3ull;
+		}
+		return result;
+	}
+
+	/// An associative container that iterates over its elements in the order they're inserted, so that output
+	/// generated by iterating over it does not depend on the values of its keys (e.g., heap addresses). References to
+	/// elements stay valid after insertions.
+	template <typename Key, typename Value> class insertion_ordered_map {
+	public:
+		using value_type = std::pair<const Key, Value>; ///< The type of elements.
+		using iterator = typename std::deque<value_type>::iterator; ///< Iterator type.
+		using const_iterator = typename std::deque<value_type>::const_iterator; ///< Const iterator type.
+
+		/// Inserts an element if there's no element with the given key. Returns an iterator to the element with the
+		/// key and whether the insertion took place.
+		template <typename ...Args> std::pair<iterator, bool> emplace(const Key &key, Args &&...args) {
+			auto [it, inserted] = _index.try_emplace(key, _storage.size());
+			if (!inserted) {
+				return { _storage.begin() + it->second, false };
+			}
+			_storage.emplace_back(
+				std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)
+			);
+			return { std::prev(_storage.end()), true };
+		}
+
+		/// Returns an iterator to the element with the given key, or \ref end() if there's none.
+		[[nodiscard]] iterator find(const Key &key) {
+			auto it = _index.find(key);
+			return it == _index.end() ? _storage.end() : _storage.begin() + it->second;
+		}
+		/// \overload
+		[[nodiscard]] const_iterator find(const Key &key) const {
+			auto it = _index.find(key);
+			return it == _index.end() ? _storage.end() : _storage.begin() + it->second;
+		}
+		/// Returns the value with the given key. The key must exist in this container.
+		[[nodiscard]] Value &at(const Key &key) {
+			auto it = _index.find(key);
+			assert_true(it != _index.end(), "key not found in insertion_ordered_map");
+			return _storage[it->second].second;
+		}
+		/// \overload
+		[[nodiscard]] const Value &at(const Key &key) const {
+			auto it = _index.find(key);
+			assert_true(it != _index.end(), "key not found in insertion_ordered_map");
+			return _storage[it->second].second;
+		}
+
+		/// Returns the number of elements.
+		[[nodiscard]] std::size_t size() const {
+			return _storage.size();
+		}
+		/// Returns whether this container is empty.
+		[[nodiscard]] bool empty() const {
+			return _storage.empty();
+		}
+
+		/// Returns an iterator to the first element.
+		[[nodiscard]] iterator begin() {
+			return _storage.begin();
+		}
+		/// \overload
+		[[nodiscard]] const_iterator begin() const {
+			return _storage.begin();
+		}
+		/// Returns an iterator past the last element.
+		[[nodiscard]] iterator end() {
+			return _storage.end();
+		}
+		/// \overload
+		[[nodiscard]] const_iterator end() const {
+			return _storage.end();
+		}
+	protected:
+		std::deque<value_type> _storage; ///< Elements in insertion order.
+		std::unordered_map<Key, std::size_t> _index; ///< Indices of elements in \ref _storage.
+	};
+
 	/// \p starts_with().
 	inline bool TEMP_starts_with(std::string_view patt, std::string_view full) {
 		if (full.size() < patt.size()) {
@@ -0,0 +1,42 @@
+#include "name_ledger.h"
+
+/// \file
+/// Implementation of \ref apigen::name_ledger.
+
+#include <clang/Index/USRGeneration.h>
+
+namespace apigen {
+	void name_ledger::load(std::istream &in) {
+		std::string line;
+		while (std::getline(in, line)) {
+			std::size_t sep = line.find('\t');
+			if (sep == std::string::npos) {
+				continue;
+			}
+			_previous.insert_or_assign(line.substr(0, sep), line.substr(sep + 1));
+		}
+	}
+
+	void name_ledger::save(std::ostream &out) const {
+		for (auto &&[key, name] : _current) {
+			out << key << "\t" << name << "\n";
+		}
+	}
+
+	std::string name_ledger::get_usr(const clang::Decl *decl) {
+		llvm::SmallString<128> usr;
+		if (clang::index::generateUSRForDecl(decl, usr)) { // returns true on failure
+			return std::string();
+		}
+		return std::string(usr.data(), usr.size());
+	}
+
+	std::string name_ledger::get_key(const clang::Decl *decl, std::string_view role) {
+		std::string result = get_usr(decl);
+		if (!result.empty()) {
+			result += "#";
+			result += role;
+		}
+		return result;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+/// \file
+/// Persistent storage of names assigned to exported entities.
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <clang/AST/Decl.h>
+
+namespace apigen {
+	/// Records the names assigned to exported entities, keyed by their clang USRs, so that names of existing entities
+	/// stay the same across runs even if other entities are added or removed.
+	class name_ledger {
+	public:
+		/// Loads names assigned in a previous run. Each line of the input contains a key and a name separated by a
+		/// tab.
+		void load(std::istream&);
+		/// Saves all names recorded using \ref record() in the format accepted by \ref load(). Names loaded from the
+		/// previous run that have not been recorded again, because their entities have been removed or their roles
+		/// are no longer generated, are dropped; unlike slots in the \ref slot_ledger, names are not kept as
+		/// tombstones.
+		void save(std::ostream&) const;
+
+		/// Returns the name assigned to the given key in the previous run, or \p nullptr if there's none.
+		[[nodiscard]] const std::string *find_previous(std::string_view key) const {
+			if (auto it = _previous.find(key); it != _previous.end()) {
+				return &it->second;
+			}
+			return nullptr;
+		}
+		/// Records the name assigned to the given key in this run.
+		void record(std::string key, std::string name) {
+			_current.insert_or_assign(std::move(key), std::move(name));
+		}
+
+		/// Returns all names loaded from the previous run.
+		[[nodiscard]] const std::map<std::string, std::string, std::less<>> &get_previous() const {
+			return _previous;
+		}
+
+		/// Returns the USR of the given declaration, or an empty string if no USR can be generated for it.
+		[[nodiscard]] static std::string get_usr(const clang::Decl*);
+		/// Returns the key of the name of the given declaration with the given role, e.g., the API function pointer
+		/// of a function and its implementation have different roles. The key is the USR followed by a \p # and
+		/// the role. Returns an empty string if no USR can be generated for the declaration.
+		[[nodiscard]] static std::string get_key(const clang::Decl*, std::string_view role);
+		/// Splits the given key into the USR and the role.
+		[[nodiscard]] static std::pair<std::string_view, std::string_view> split_key(std::string_view key) {
+			std::size_t sep = key.rfind('#');
+			if (sep == std::string_view::npos) {
+				return { key, std::string_view() };
+			}
+			return { key.substr(0, sep), key.substr(sep + 1) };
+		}
+	protected:
+		/// The mapping type used to store names.
+		using _mapping = std::map<std::string, std::string, std::less<>>;
+
+		_mapping
+			_previous, ///< Names loaded from the previous run.
+			_current; ///< Names recorded in this run.
+	};
+}
@@ -20,6 +20,10 @@ namespace apigen {
 		return get_user_type_name(ent);
 	}
 
+	std::string naming_convention::shorten_name(std::string name) {
+		return name;
+	}
+
 	naming_convention::name_info naming_convention::get_user_type_name_dynamic(
 		const entities::user_type_entity &ent
 	) {
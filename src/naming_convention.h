@@ -5,6 +5,7 @@
 
 #include <string>
 #include <map>
+#include <functional>
 
 #include <clang/AST/Decl.h>
 
@@ -25,15 +26,26 @@ namespace apigen {
 	public:
 		/// A name and another string that helps disambiguate the name.
 		struct name_info {
+			/// A function that computes the disambiguation string.
+			using disambiguation_producer = std::function<std::string()>;
+
 			/// Default constructor.
 			name_info() = default;
 			/// Initializes all fields of this struct.
 			name_info(std::string n, std::string dis) : name(std::move(n)), disambiguation(std::move(dis)) {
 			}
+			/// Initializes the name and the function that computes the disambiguation string. The function is only
+			/// invoked if the disambiguation string is needed to resolve name conflicts.
+			name_info(std::string n, disambiguation_producer producer) :
+				name(std::move(n)), lazy_disambiguation(std::move(producer)) {
+			}
 
 			std::string
 				name, ///< The short name.
 				disambiguation; ///< The string used to help disambiguate the name.
+			/// If non-empty, this function is used to compute the disambiguation string instead of
+			/// \ref disambiguation.
+			disambiguation_producer lazy_disambiguation;
 		};
 
 		/// Default virtual destructor.
@@ -57,8 +69,16 @@ namespace apigen {
 		[[nodiscard]] virtual name_info get_enum_name(const entities::enum_entity&);
 
 		// functions used to get names related to an entity
+		/// Returns the exported name of the batch variant of the given \ref entities::function_entity.
+		[[nodiscard]] virtual name_info get_function_batch_name(const entities::function_entity&) = 0;
 		/// Returns the exported name of the destructor of the given \ref entities::record_entity.
 		[[nodiscard]] virtual name_info get_record_destructor_name(const entities::record_entity&) = 0;
+		/// Returns the exported name of the function that copies fields of the given \ref entities::record_entity
+		/// into its view.
+		[[nodiscard]] virtual name_info get_record_snapshot_name(const entities::record_entity&) = 0;
+		/// Returns the exported name of the function that writes fields of the view of the given
+		/// \ref entities::record_entity back into an object.
+		[[nodiscard]] virtual name_info get_record_apply_name(const entities::record_entity&) = 0;
 
 		/// Returns the name of an enumerator in the enum declaration.
 		[[nodiscard]] virtual name_info get_enumerator_name(
@@ -69,6 +89,13 @@ namespace apigen {
 		[[nodiscard]] virtual name_info get_field_getter_name(const entities::field_entity&) = 0;
 		/// Returns the exportedname of the const getter of the given field.
 		[[nodiscard]] virtual name_info get_field_const_getter_name(const entities::field_entity&) = 0;
+		/// Returns the exported name of the function that copies the given array field out of an object.
+		[[nodiscard]] virtual name_info get_field_copy_out_name(const entities::field_entity&) = 0;
+		/// Returns the exported name of the function that copies the given array field into an object.
+		[[nodiscard]] virtual name_info get_field_copy_in_name(const entities::field_entity&) = 0;
+		/// Returns the identifier actually used for the given composed name, which already contains any
+		/// disambiguation postfix and numbering. By default this function returns the name as-is.
+		[[nodiscard]] virtual std::string shorten_name(std::string);
 
 		// functions below are used to dispatch the call to the corresponding type
 		/// Dispatches the call to \ref get_enum_name() or \ref get_record_name() depending on the actual type of the
@@ -90,17 +117,38 @@ namespace apigen {
 			/// The pattern of the name of struct sizes.
 			size_name_pattern = "{}_size",
 			/// The pattern of the name of struct alignments.
-			align_name_pattern = "{}_align";
+			align_name_pattern = "{}_align",
+			/// The pattern of the name of structs that provide storage for records.
+			storage_name_pattern = "{}_storage",
+			/// The pattern of the name of vector types, given the name of the element type and the number of
+			/// elements.
+			vector_type_name_pattern = "{}_vec{}",
+			/// The pattern of the name of array types, given the name of the element type and the extents separated
+			/// by \p x.
+			array_type_name_pattern = "{}_array{}",
+			/// The pattern of the name of inline field getters in the API header, given the name of the getter in the
+			/// API structure.
+			inline_accessor_name_pattern = "{}_inline",
+			/// The pattern of the name of structs that hold copies of the fields of records.
+			view_name_pattern = "{}_view",
+			/// The pattern of the name of the indices of the bits that select writable fields of views, given the name
+			/// of the view and the name of the field. Const fields get no such name.
+			view_bit_name_pattern = "{}_{}_bit";
 	};
 
 	/// Naming information of special functions such as constructors, destructors, and overloaded operators.
 	struct special_function_naming {
 		std::string_view
 			constructor_name{ "ctor" }, ///< The name of constructors.
+			batch_name{ "batch" }, ///< The suffix of batch variants of functions.
 			destructor_name{ "dtor" }, ///< The name of destructors.
+			snapshot_name{ "snapshot" }, ///< The name of functions that copy fields of records into views.
+			apply_name{ "apply" }, ///< The name of functions that write fields of views back into records.
 
 			getter_name{ "getter" }, ///< The name of field getters.
 			const_getter_name{ "const_getter" }, ///< The name of const getters.
+			copy_out_name{ "copy_out" }, ///< The name of functions that copy array fields out of objects.
+			copy_in_name{ "copy_in" }, ///< The name of functions that copy array fields into objects.
 
 			new_name{ "new" }, ///< The name of <cc>operator new</cc>.
 			delete_name{ "delete" }, ///< The name of <cc>operator delete</cc>.
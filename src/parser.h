@@ -10,6 +10,7 @@
 
 #include "misc.h"
 #include "entity_registry.h"
+#include "logger.h"
 
 namespace apigen {
 	/// Parses files and keeps a registry of all entities in the code.
@@ -41,7 +42,7 @@ namespace apigen {
 			_compiler.setASTConsumer(llvm::make_unique<_ast_consumer>(visitor));
 
 			if (_compiler.getFrontendOpts().Inputs.size() > 1) {
-				std::cerr << "warning: main file not unique\n";
+				logger::get().log(log_category::parsing, log_level::warning, "main file not unique");
 			}
 			const clang::FileEntry *file =
 				_compiler.getFileManager().getFile(_compiler.getFrontendOpts().Inputs[0].getFile());
@@ -0,0 +1,67 @@
+#include "slot_ledger.h"
+
+/// \file
+/// Implementation of \ref apigen::slot_ledger.
+
+#include <cstdlib>
+#include <set>
+
+#include "logger.h"
+
+namespace apigen {
+	void slot_ledger::load(std::istream &in) {
+		std::string line;
+		while (std::getline(in, line)) {
+			std::size_t sep = line.find('\t');
+			if (sep == std::string::npos) {
+				continue;
+			}
+			std::string_view kind = std::string_view(line).substr(0, sep);
+			std::string value = line.substr(sep + 1);
+			if (kind == "version") {
+				_version = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+			} else if (kind == "slot") {
+				_slots.emplace_back(std::move(value), false);
+			} else if (kind == "tombstone") {
+				_slots.emplace_back(std::move(value), true);
+			} else {
+				logger::get().log(log_category::general, log_level::warning, "unknown slot ledger entry: {}", line);
+			}
+		}
+	}
+
+	void slot_ledger::save(std::ostream &out) const {
+		out << "version\t" << _version << "\n";
+		for (const slot &s : _slots) {
+			out << (s.tombstone ? "tombstone\t" : "slot\t") << s.name << "\n";
+		}
+	}
+
+	void slot_ledger::update(const std::vector<std::string_view> &names) {
+		std::set<std::string_view> current(names.begin(), names.end());
+		std::set<std::string, std::less<>> live;
+		bool changed = false;
+		for (slot &s : _slots) {
+			if (s.tombstone) {
+				continue;
+			}
+			if (current.find(s.name) == current.end()) {
+				logger::get().log(log_category::exporting, log_level::info, "slot {} becomes a tombstone", s.name);
+				s.tombstone = true;
+				changed = true;
+			} else {
+				live.emplace(s.name);
+			}
+		}
+		for (std::string_view name : names) {
+			if (live.emplace(name).second) {
+				logger::get().log(log_category::exporting, log_level::info, "slot {} appended", name);
+				_slots.emplace_back(std::string(name), false);
+				changed = true;
+			}
+		}
+		if (changed) {
+			++_version;
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+/// \file
+/// Persistent layout of the API structure.
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace apigen {
+	/// Records the order of the members of the API structure across runs, so that its layout only ever grows at the
+	/// end. Members of removed entities are kept as tombstones so that the offsets of all following members stay the
+	/// same.
+	class slot_ledger {
+	public:
+		/// A member of the API structure.
+		struct slot {
+			/// Default constructor.
+			slot() = default;
+			/// Initializes all fields of this struct.
+			slot(std::string n, bool tomb) : name(std::move(n)), tombstone(tomb) {
+			}
+
+			std::string name; ///< The name of the member, or the name it had before it was removed.
+			bool tombstone = false; ///< Whether the entity of this slot has been removed.
+		};
+
+		/// Loads the layout saved by a previous run. The first line contains the version, and each following line
+		/// contains a slot, in the format written by \ref save().
+		void load(std::istream&);
+		/// Saves the layout in the format accepted by \ref load().
+		void save(std::ostream&) const;
+
+		/// Updates the layout so that it contains all the given slots. Existing slots keep their positions, slots
+		/// that are no longer present become tombstones, and new slots are appended in the given order. The version
+		/// is incremented if anything changes.
+		void update(const std::vector<std::string_view>&);
+
+		/// Returns \ref _slots.
+		[[nodiscard]] const std::vector<slot> &get_slots() const {
+			return _slots;
+		}
+		/// Returns \ref _version.
+		[[nodiscard]] std::uint32_t get_version() const {
+			return _version;
+		}
+	protected:
+		std::vector<slot> _slots; ///< All slots in the order they appear in the API structure.
+		std::uint32_t _version = 0; ///< The number of times the layout has changed.
+	};
+}
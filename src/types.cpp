@@ -16,11 +16,19 @@ namespace apigen {
 				reference_kind::reference;
 			canon_type = canon_type->getPointeeType();
 		}
+		bool outermost_arrays = true; // whether all levels so far are fixed-size arrays
 		while (true) {
 			result.qualifiers.emplace_back(convert_qualifiers(canon_type.getQualifiers()));
 			if (canon_type->isPointerType()) {
+				outermost_arrays = false;
 				canon_type = canon_type->getPointeeType();
 			} else if (auto *arrty = llvm::dyn_cast<clang::ArrayType>(canon_type.getTypePtr())) {
+				auto *const_arrty = llvm::dyn_cast<clang::ConstantArrayType>(arrty);
+				if (const_arrty && outermost_arrays) {
+					result.array_extents.emplace_back(const_arrty->getSize().getZExtValue());
+				} else {
+					outermost_arrays = false;
+				}
 				canon_type = arrty->getElementType();
 			} else {
 				break;
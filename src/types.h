@@ -64,6 +64,14 @@ namespace apigen {
 		[[nodiscard]] bool is_reference_or_pointer() const {
 			return is_reference() || qualifiers.size() > 1;
 		}
+		/// Returns \p true if this type is a fixed-size array. See \ref array_extents.
+		[[nodiscard]] bool is_array() const {
+			return !array_extents.empty();
+		}
+		/// Returns the qualifiers of the elements of this array type, or of this type itself if it's not an array.
+		[[nodiscard]] qualifier get_element_qualifiers() const {
+			return qualifiers[array_extents.size()];
+		}
 		/// Returns \p true if this type is \p void.
 		[[nodiscard]] bool is_void() const {
 			return !is_reference_or_pointer() && type->isVoidType();
@@ -82,6 +90,10 @@ namespace apigen {
 		/// For each pointer level this vector should have one more element indicating that pointer level's
 		/// qualifiers. The qualifiers in the front are those of the outer layers.
 		std::vector<qualifier> qualifiers;
+		/// The extents of the outermost levels of this type that are fixed-size arrays, starting from the outermost
+		/// one. Each of these levels also has an element in \ref qualifiers, so that code that doesn't handle arrays
+		/// treats them as pointers.
+		std::vector<std::uint64_t> array_extents;
 		reference_kind ref_kind = reference_kind::none; /// Indicates what kind of reference this type is (if any).
 		const clang::Type *type = nullptr; ///< The underlying type.
 		/// The entity associated with the base type, or \p nullptr if this is a primitive type.
@@ -0,0 +1,53 @@
+# Runs apigen twice on the same input, first with a single thread and then with several, and checks that both runs
+# produce the same set of files with byte-for-byte identical contents.
+#
+# Expects APIGEN (path to the executable), SOURCE_DIR (root of the repository), and WORK_DIR (a scratch directory).
+
+set(INPUT_FILE "${SOURCE_DIR}/test/determinism/input.cpp")
+
+foreach(JOBS IN ITEMS 1 4)
+	set(OUTPUT_DIR "${WORK_DIR}/jobs_${JOBS}")
+	file(REMOVE_RECURSE "${OUTPUT_DIR}")
+	file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+	execute_process(
+		COMMAND "${APIGEN}"
+			"--api_header_file=${OUTPUT_DIR}/api.h"
+			"--host_header_file=${OUTPUT_DIR}/host.h"
+			"--host_source_file=${OUTPUT_DIR}/host.cpp"
+			"--collect_source_file=${OUTPUT_DIR}/collect.cpp"
+			"--api_module_file=${OUTPUT_DIR}/api.ixx"
+			"--manifest_json_file=${OUTPUT_DIR}/manifest.json"
+			"--manifest_binary_file=${OUTPUT_DIR}/manifest.bin"
+			"--host_shards=3"
+			"--jobs=${JOBS}"
+			"--split_api_header"
+			"--direct_link"
+			"--record_views"
+			"--by_value_record_size=16"
+			--
+			"${INPUT_FILE}" -std=c++17 "-I${SOURCE_DIR}/src"
+		RESULT_VARIABLE RESULT
+		OUTPUT_VARIABLE OUTPUT
+		ERROR_VARIABLE OUTPUT
+	)
+	if(NOT RESULT EQUAL 0)
+		message(FATAL_ERROR "apigen failed with --jobs=${JOBS} (${RESULT}):\n${OUTPUT}")
+	endif()
+endforeach()
+
+file(GLOB FIRST_FILES RELATIVE "${WORK_DIR}/jobs_1" "${WORK_DIR}/jobs_1/*")
+file(GLOB SECOND_FILES RELATIVE "${WORK_DIR}/jobs_4" "${WORK_DIR}/jobs_4/*")
+list(SORT FIRST_FILES)
+list(SORT SECOND_FILES)
+if(NOT FIRST_FILES STREQUAL SECOND_FILES)
+	message(FATAL_ERROR "the runs produced different files:\n  ${FIRST_FILES}\n  ${SECOND_FILES}")
+endif()
+foreach(FILE IN LISTS FIRST_FILES)
+	execute_process(
+		COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/jobs_1/${FILE}" "${WORK_DIR}/jobs_4/${FILE}"
+		RESULT_VARIABLE DIFFERENT
+	)
+	if(DIFFERENT)
+		message(FATAL_ERROR "${FILE} differs between runs")
+	endif()
+endforeach()
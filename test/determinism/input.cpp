@@ -0,0 +1,49 @@
+// Input of the determinism check. It declares entities in several namespaces, overloads that need disambiguation,
+// and records with fields, so that the order of every output depends on how entities are collected and named.
+
+#include "apigen_definitions.h"
+
+namespace geometry {
+	enum class APIGEN_EXPORT shape_kind {
+		circle,
+		rectangle
+	};
+
+	struct APIGEN_EXPORT_RECURSIVE point {
+		float x = 0.0f, y = 0.0f;
+
+		point() = default;
+		point(float px, float py) : x(px), y(py) {
+		}
+
+		[[nodiscard]] float length() const;
+		void scale(float);
+		void scale(float, float);
+	};
+
+	struct APIGEN_EXPORT_RECURSIVE shape {
+		shape_kind kind = shape_kind::circle;
+		point origin;
+		float extents[2]{};
+
+		[[nodiscard]] float area() const;
+	};
+
+	APIGEN_EXPORT shape make_circle(point, float);
+	APIGEN_EXPORT shape make_rectangle(point, point);
+}
+
+namespace render {
+	struct APIGEN_EXPORT_RECURSIVE canvas {
+		int width = 0, height = 0;
+
+		canvas(int, int);
+
+		void draw(const geometry::shape&);
+		void draw(const geometry::point&);
+		void clear();
+	};
+}
+
+APIGEN_EXPORT int version();
+APIGEN_EXPORT int version(int component);